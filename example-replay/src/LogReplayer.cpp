@@ -0,0 +1,151 @@
+#include "LogReplayer.h"
+#include "ofxSuperLog.h"
+
+//--------------------------------------------------------------
+// "[notice ]    module: 2020/01/31 14:32:00.123456 - message" (timestamp and micros are optional)
+bool LogReplayer::parseHeader(const string & line, Record & r){
+
+	if(line.size() < 3 || line[0] != '[') return false;
+	size_t close = line.find(']');
+	if(close == string::npos) return false;
+
+	string levelName = ofTrim(line.substr(1, close - 1));
+	if(levelName == "verbose") r.level = OF_LOG_VERBOSE;
+	else if(levelName == "notice") r.level = OF_LOG_NOTICE;
+	else if(levelName == "warning") r.level = OF_LOG_WARNING;
+	else if(levelName == "error") r.level = OF_LOG_ERROR;
+	else if(levelName == "fatal") r.level = OF_LOG_FATAL_ERROR;
+	else return false;
+
+	size_t colon = line.find(": ", close);
+	if(colon == string::npos){
+		r.module = "";
+		r.message = ofTrim(line.substr(close + 1));
+		return true;
+	}
+	r.module = ofTrim(line.substr(close + 1, colon - close - 1));
+	r.message = line.substr(colon + 2);
+
+	int Y, M, D, h, m, s, us = 0, n = 0;
+	const char * ts = r.message.c_str();
+	if(sscanf(ts, "%4d/%2d/%2d %2d:%2d:%2d%n", &Y, &M, &D, &h, &m, &s, &n) == 6){
+		if(ts[n] == '.'){
+			int n2 = 0;
+			sscanf(ts + n, ".%6d%n", &us, &n2);
+			n += n2;
+		}
+		if(r.message.compare(n, 3, " - ") == 0){
+			std::tm t = {};
+			t.tm_year = Y - 1900; t.tm_mon = M - 1; t.tm_mday = D;
+			t.tm_hour = h; t.tm_min = m; t.tm_sec = s;
+			t.tm_isdst = -1;
+			r.time = int64_t(std::mktime(&t)) * 1000000 + us;
+			r.message = r.message.substr(n + 3);
+		}
+	}
+	return true;
+}
+
+//--------------------------------------------------------------
+bool LogReplayer::load(const string & path){
+
+	records.clear();
+	ofBuffer buffer = ofBufferFromFile(path);
+	bool haveMicros = false;
+	for(auto & line : buffer.getLines()){
+		Record r;
+		if(parseHeader(line, r)){
+			haveMicros |= r.time >= 0 && r.time % 1000000 != 0;
+			records.push_back(std::move(r));
+		}else if(records.size()){ //continuation of a multi-line message
+			records.back().message += "\n" + line;
+		}
+	}
+
+	//second resolution timestamps: spread the records of each second evenly across it
+	if(!haveMicros){
+		for(size_t i = 0; i < records.size();){
+			size_t j = i;
+			while(j < records.size() && records[j].time == records[i].time) j++;
+			for(size_t k = i; k < j; k++){
+				if(records[k].time >= 0) records[k].time += (k - i) * 1000000 / (j - i);
+			}
+			i = j;
+		}
+	}
+	ofLogNotice("LogReplayer") << "loaded " << records.size() << " records from " << path;
+	return records.size() > 0;
+}
+
+//--------------------------------------------------------------
+//v is sorted, in ns; returns us
+static double percentile(vector<uint64_t> & v, double p){
+	if(v.empty()) return 0;
+	size_t i = std::min(v.size() - 1, size_t(p * v.size()));
+	return v[i] / 1000.0;
+}
+
+LogReplayer::Results LogReplayer::replay(ofxSuperLog * logger, int numThreads, float speed){
+
+	using namespace std::chrono;
+	Results res;
+	numThreads = std::max(numThreads, 1);
+
+	int64_t t0 = -1;
+	for(auto & r : records){
+		if(r.time >= 0){ t0 = r.time; break; }
+	}
+	if(speed > 0 && t0 < 0){
+		ofLogWarning("LogReplayer") << "the log has no timestamps, replaying as fast as possible";
+		speed = 0;
+	}
+
+	std::atomic<size_t> next(0);
+	vector<vector<uint64_t>> latencies(numThreads);
+	vector<vector<uint64_t>> lags(numThreads);
+	vector<std::thread> threads;
+	auto start = steady_clock::now();
+
+	for(int t = 0; t < numThreads; t++){
+		threads.emplace_back([&, t]{
+			ofxSuperLog::setThreadName("replay" + ofToString(t));
+			latencies[t].reserve(records.size() / numThreads + 1);
+			int64_t lastTime = t0;
+			size_t i;
+			while((i = next++) < records.size()){
+				const Record & r = records[i];
+				if(speed > 0){
+					if(r.time >= 0) lastTime = r.time;
+					auto target = start + microseconds(int64_t((lastTime - t0) / speed));
+					std::this_thread::sleep_until(target);
+					lags[t].push_back(duration_cast<nanoseconds>(steady_clock::now() - target).count());
+				}
+				auto before = steady_clock::now();
+				logger->log(r.level, r.module, r.message);
+				latencies[t].push_back(duration_cast<nanoseconds>(steady_clock::now() - before).count());
+			}
+		});
+	}
+	for(auto & t : threads) t.join();
+	res.seconds = duration<double>(steady_clock::now() - start).count();
+
+	vector<uint64_t> all, allLags;
+	for(int t = 0; t < numThreads; t++){
+		all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+		allLags.insert(allLags.end(), lags[t].begin(), lags[t].end());
+	}
+	std::sort(all.begin(), all.end());
+	std::sort(allLags.begin(), allLags.end());
+
+	res.numRecords = records.size();
+	for(auto & r : records) res.numBytes += r.message.size() + r.module.size();
+	res.p50 = percentile(all, 0.5);
+	res.p90 = percentile(all, 0.9);
+	res.p99 = percentile(all, 0.99);
+	res.p999 = percentile(all, 0.999);
+	res.max = all.size() ? all.back() / 1000.0 : 0;
+	res.lagP50 = percentile(allLags, 0.5);
+	res.lagP99 = percentile(allLags, 0.99);
+	res.lagMax = allLags.size() ? allLags.back() / 1000.0 : 0;
+	return res;
+}
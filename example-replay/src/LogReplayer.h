@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ofMain.h"
+
+class ofxSuperLog;
+
+/// Reads a log file written by ofxSuperLog's file sink and replays its records through
+/// ofxSuperLog::log() from several threads, either with the original inter-arrival timing
+/// (optionally scaled) or as fast as possible, measuring how long each log() call takes.
+/// Expects the default file layout; lines from a custom setFileLogFormat() pattern aren't recognized.
+class LogReplayer{
+
+	public:
+
+		struct Record{
+			ofLogLevel level;
+			string module;
+			string message;
+			int64_t time = -1; //us, -1 if the line had no timestamp
+		};
+
+		struct Results{
+			size_t numRecords = 0;
+			size_t numBytes = 0;
+			double seconds = 0;
+			double p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0; //log() latency, us (measured in ns, most calls take well under 1us)
+			double lagP50 = 0, lagP99 = 0, lagMax = 0; //how late records went out vs their schedule, us
+		};
+
+		bool load(const string & path);
+
+		///speed 1 replays in real time, 2 twice as fast, etc. 0 is as fast as possible.
+		Results replay(ofxSuperLog * logger, int numThreads, float speed);
+
+	protected:
+
+		bool parseHeader(const string & line, Record & r);
+		vector<Record> records;
+};
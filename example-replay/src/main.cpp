@@ -0,0 +1,17 @@
+#include "ofApp.h"
+#include "ofAppNoWindow.h"
+
+// usage: example-replay path/to/recorded.log [numThreads = 4] [speed = 0] [logToConsole = 0]
+// speed is relative to the original timing (1 = real time, 10 = 10x faster), 0 replays as fast as possible.
+
+int main(int argc, char ** argv){
+
+	auto window = std::make_shared<ofAppNoWindow>(); //we only want to drive the logger, no need for a gl context
+	ofSetupOpenGL(window, 1024, 768, OF_WINDOW);
+
+	ofApp * app = new ofApp();
+	for(int i = 1; i < argc; i++){
+		app->args.push_back(argv[i]);
+	}
+	ofRunApp(app);
+}
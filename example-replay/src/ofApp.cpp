@@ -0,0 +1,41 @@
+#include "ofApp.h"
+
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+
+	if(args.empty()){
+		cout << "usage: example-replay path/to/recorded.log [numThreads = 4] [speed = 0] [logToConsole = 0]" << endl;
+		ofExit(1);
+		return;
+	}
+	string path = args[0];
+	int numThreads = args.size() > 1 ? ofToInt(args[1]) : 4;
+	float speed = args.size() > 2 ? ofToFloat(args[2]) : 0;
+	bool logToConsole = args.size() > 3 ? ofToInt(args[3]) != 0 : false;
+
+	if(!replayer.load(path)){
+		cout << "can't read any records from " << path << endl;
+		ofExit(1);
+		return;
+	}
+
+	//the logger under test, replayed records end up in data/replayLogs
+	ofSetLoggerChannel(ofxSuperLog::getLogger(logToConsole, true, "replayLogs"));
+	ofSetLogLevel(OF_LOG_VERBOSE);
+
+	LogReplayer::Results r = replayer.replay(ofxSuperLog::getLogger().get(), numThreads, speed);
+
+	cout << "replayed " << r.numRecords << " records (" << r.numBytes / (1024 * 1024) << " MB) from " << numThreads << " threads in " << r.seconds << "s" << endl;
+	cout << "throughput: " << r.numRecords / r.seconds << " records/s, " << r.numBytes / r.seconds / (1024 * 1024) << " MB/s" << endl;
+	cout << "log() latency (us): p50 " << r.p50 << "  p90 " << r.p90 << "  p99 " << r.p99 << "  p99.9 " << r.p999 << "  max " << r.max << endl;
+	if(speed > 0){
+		cout << "schedule lag (us): p50 " << r.lagP50 << "  p99 " << r.lagP99 << "  max " << r.lagMax << endl;
+	}
+	ofExit(0);
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+
+}
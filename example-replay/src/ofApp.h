@@ -0,0 +1,15 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxSuperLog.h"
+#include "LogReplayer.h"
+
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+
+		vector<string> args;
+		LogReplayer replayer;
+};
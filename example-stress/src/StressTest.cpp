@@ -0,0 +1,251 @@
+#include "StressTest.h"
+#include "ofxSuperLog.h"
+
+#ifdef TARGET_WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+#define STRESS_MARKER "stress t="
+
+//--------------------------------------------------------------
+StressTest::~StressTest(){
+	for(auto & t : threads){
+		if(t.joinable()) t.join();
+	}
+}
+
+//--------------------------------------------------------------
+uint32_t StressTest::checksum(const char * data, size_t len){
+	uint32_t h = 2166136261u;
+	for(size_t i = 0; i < len; i++){
+		h ^= (uint8_t)data[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+//--------------------------------------------------------------
+string StressTest::makeMessage(int thread, int index, size_t payloadLen){
+	string payload(payloadLen, ' ');
+	for(size_t i = 0; i < payloadLen; i++){
+		payload[i] = 'a' + (thread * 7 + index * 13 + i) % 26;
+	}
+	char header[64];
+	snprintf(header, sizeof(header), STRESS_MARKER "%d i=%d sum=%08x ", thread, index, checksum(payload.data(), payload.size()));
+	return header + payload;
+}
+
+//--------------------------------------------------------------
+void StressTest::start(ofxSuperLog * logger_, int numThreads_, int recordsPerThread_, bool checkConsole){
+
+	logger = logger_;
+	numThreads = numThreads_;
+	recordsPerThread = recordsPerThread_;
+
+	if(checkConsole){ //stdout goes to a file until verify(), stderr (errors only, we log none) stays
+		consoleFile = ofToDataPath("stressConsole.txt", true);
+		savedStdout = redirectStdout(consoleFile);
+		if(savedStdout < 0) consoleFile.clear();
+	}
+	logger->setHistorySize(numThreads * recordsPerThread + 1000);
+
+	subscriptionCheck.setup("subscription", numThreads);
+	subscriptionId = logger->subscribe([this](const vector<ofxSuperLogSubscriptions::Record> & records){
+		std::lock_guard<std::mutex> lock(subscriptionMutex);
+		for(auto & r : records) subscriptionCheck.check(r.message);
+	});
+
+	startTime = ofGetElapsedTimeMicros();
+	for(int t = 0; t < numThreads; t++){
+		threads.emplace_back([this, t, numThreads = numThreads]{ //not threads.size(), still growing while the first ones run
+			ofxSuperLog::setThreadName("stress" + ofToString(t));
+			//module names of different lengths, they all fight over the module column width
+			string module = "worker" + string(t % 12, '_') + ofToString(t);
+			for(int i = 0; i < recordsPerThread; i++){
+				string msg = makeMessage(t, i, 16 + (i * 31 + t) % 200);
+				ofLogLevel level = i % 50 == 0 ? OF_LOG_WARNING : OF_LOG_NOTICE;
+				ofLog(level, module) << msg; //through ofLog, like the app would
+				numBytes += msg.size();
+				numLogged++;
+			}
+			if(++numFinished == numThreads) endTime = ofGetElapsedTimeMicros();
+		});
+	}
+}
+
+//--------------------------------------------------------------
+StressTest::Results StressTest::verify(const string & mode){
+
+	for(auto & t : threads) t.join();
+
+	Results r;
+	r.numRecords = numLogged;
+	r.numBytes = numBytes;
+	r.seconds = (endTime - startTime) / 1000000.0;
+
+	//everything out of the queues & buffers
+	logger->flushOrderedLogging();
+	logger->flushLogFile();
+	logger->flushSubscriptions();
+	logger->unsubscribe(subscriptionId);
+
+	SinkCheck consoleCheck;
+	consoleCheck.setup("console", numThreads);
+	if(savedStdout >= 0){
+		restoreStdout(savedStdout);
+		savedStdout = -1;
+		ofBuffer consoleBuf = ofBufferFromFile(consoleFile);
+		for(auto line : consoleBuf.getLines()){
+			consoleCheck.check(stripColors(line));
+		}
+	}
+
+	//the app clears the panel & turns it on and off, so lines go missing there; none should show up twice or torn
+	SinkCheck displayCheck;
+	displayCheck.setup("display", numThreads);
+	vector<string> displayLines;
+	logger->getDisplayLogger().getLines(displayLines);
+	for(auto & line : displayLines){
+		displayCheck.check(line);
+	}
+
+	SinkCheck fileCheck;
+	fileCheck.setup("file", numThreads);
+	ofBuffer buf = ofBufferFromFile(logger->getCurrentLogFile());
+	for(auto line : buf.getLines()){
+		fileCheck.check(line);
+	}
+
+	SinkCheck historyCheck;
+	historyCheck.setup("history", numThreads);
+	auto history = logger->getHistory();
+	for(size_t i = 0; i < history.size(); i++){
+		historyCheck.check(history[i].message);
+	}
+
+	std::lock_guard<std::mutex> lock(subscriptionMutex);
+	uint64_t subscriptionDrops = logger->getNumSubscriptionDrops();
+
+	bool console = consoleFile.size() > 0;
+	r.ok = fileCheck.numLost(recordsPerThread) == 0 && historyCheck.numLost(recordsPerThread) == 0 &&
+		   subscriptionCheck.numLost(recordsPerThread) == subscriptionDrops;
+	for(auto * c : {&fileCheck, &historyCheck, &subscriptionCheck}){
+		r.ok &= c->numTorn == 0 && c->numDuplicated == 0 && c->numOutOfOrder == 0;
+	}
+	if(console){
+		r.ok &= consoleCheck.numLost(recordsPerThread) == 0 && consoleCheck.numTorn == 0 &&
+				consoleCheck.numDuplicated == 0 && consoleCheck.numOutOfOrder == 0;
+	}
+	r.ok &= displayCheck.numTorn == 0 && displayCheck.numDuplicated == 0; //gaps are out of order there, expected
+
+	r.report = string(r.ok ? "PASSED" : "FAILED") + " - " + mode + " logging, " + ofToString(numThreads) + " threads x " +
+			   ofToString(recordsPerThread) + " records\n";
+	r.report += "throughput: " + ofToString(r.numRecords / r.seconds, 0) + " records/s, " + ofToString(r.numBytes / r.seconds / (1024 * 1024), 2) + " MB/s\n";
+	r.report += fileCheck.describe(recordsPerThread) + "\n";
+	r.report += historyCheck.describe(recordsPerThread) + "\n";
+	r.report += subscriptionCheck.describe(recordsPerThread) + " (" + ofToString(subscriptionDrops) + " dropped by the dispatch queue)\n";
+	if(console) r.report += consoleCheck.describe(recordsPerThread) + "\n";
+	r.report += "display: " + ofToString(displayCheck.numGood + displayCheck.numOutOfOrder) + " lines in the panel, " + ofToString(displayCheck.numTorn) + " torn, " +
+				ofToString(displayCheck.numDuplicated) + " duplicated (it's cleared during the test, lost lines aren't counted)";
+	return r;
+}
+
+//--------------------------------------------------------------
+int StressTest::redirectStdout(const string & path){
+	cout.flush();
+	fflush(stdout);
+	FILE * f = fopen(path.c_str(), "w");
+	if(!f) return -1;
+	#ifdef TARGET_WIN32
+	int saved = _dup(_fileno(stdout));
+	_dup2(_fileno(f), _fileno(stdout));
+	#else
+	int saved = dup(fileno(stdout));
+	dup2(fileno(f), fileno(stdout));
+	#endif
+	fclose(f);
+	return saved;
+}
+
+//--------------------------------------------------------------
+void StressTest::restoreStdout(int saved){
+	cout.flush();
+	fflush(stdout);
+	#ifdef TARGET_WIN32
+	_dup2(saved, _fileno(stdout));
+	_close(saved);
+	#else
+	dup2(saved, fileno(stdout));
+	close(saved);
+	#endif
+}
+
+//--------------------------------------------------------------
+string StressTest::stripColors(const string & line){
+	//"\033[0;32m" ... "\033[0;0m" around the message on color terminals
+	string out;
+	out.reserve(line.size());
+	for(size_t i = 0; i < line.size(); i++){
+		if(line[i] == '\033'){
+			size_t end = line.find('m', i);
+			if(end != string::npos){
+				i = end;
+				continue;
+			}
+		}
+		out += line[i];
+	}
+	return out;
+}
+
+//--------------------------------------------------------------
+void StressTest::SinkCheck::setup(const string & name_, int numThreads){
+	name = name_;
+	lastIndex.assign(numThreads, -1);
+}
+
+//--------------------------------------------------------------
+void StressTest::SinkCheck::check(const string & message){
+
+	size_t start = message.find(STRESS_MARKER);
+	if(start == string::npos){
+		numForeign++;
+		return;
+	}
+	int thread, index, n = 0;
+	unsigned int sum;
+	const char * p = message.c_str() + start;
+	if(sscanf(p, STRESS_MARKER "%d i=%d sum=%8x %n", &thread, &index, &sum, &n) != 3 || n == 0 ||
+	   thread < 0 || thread >= (int)lastIndex.size() || message.find(STRESS_MARKER, start + 1) != string::npos){
+		numTorn++;
+		return;
+	}
+	const char * payload = p + n;
+	if(checksum(payload, message.c_str() + message.size() - payload) != sum){
+		numTorn++;
+		return;
+	}
+	int64_t & last = lastIndex[thread];
+	if(index <= last){
+		numDuplicated++;
+	}else if(index != last + 1){
+		numOutOfOrder++; //or lost, numLost() will tell
+		last = index;
+	}else{
+		numGood++;
+		last = index;
+	}
+}
+
+//--------------------------------------------------------------
+size_t StressTest::SinkCheck::numLost(int recordsPerThread){
+	return lastIndex.size() * recordsPerThread - numGood - numOutOfOrder;
+}
+
+//--------------------------------------------------------------
+string StressTest::SinkCheck::describe(int recordsPerThread){
+	return name + ": " + ofToString(numGood) + " good, " + ofToString(numLost(recordsPerThread)) + " lost, " + ofToString(numTorn) + " torn, " +
+		   ofToString(numDuplicated) + " duplicated, " + ofToString(numOutOfOrder) + " out of order, " + ofToString(numForeign) + " other lines";
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxSuperLogHistory.h"
+
+class ofxSuperLog;
+
+/// Logs tagged, checksummed records from many threads through ofxSuperLog, then checks what came
+/// out of the file sink, the subscription sink, the in-memory history and (optionally) the console:
+/// every record exactly once, intact, and in order for each thread. The screen log is checked for
+/// torn and duplicated lines; the app clears it during the test, so lines lost there can't be told.
+///
+/// Record messages look like "stress t=3 i=1234 sum=9f3a01bc payload", sum being the FNV-1a hash
+/// of the payload, so a torn or mixed-up line can't pass as a good one.
+class StressTest{
+
+	public:
+
+		struct Results{
+			bool ok = false;
+			size_t numRecords = 0;
+			size_t numBytes = 0;
+			double seconds = 0;
+			string report;
+		};
+
+		~StressTest();
+
+		///checkConsole redirects stdout to data/stressConsole.txt until verify(), to check the console sink too
+		void start(ofxSuperLog * logger, int numThreads, int recordsPerThread, bool checkConsole = false);
+		bool isDone(){return numFinished == numThreads;}
+		size_t getNumLogged(){return numLogged;}
+
+		///call once isDone()
+		Results verify(const string & mode);
+
+	protected:
+
+		struct SinkCheck{
+			string name;
+			vector<int64_t> lastIndex; //per thread
+			size_t numGood = 0;
+			size_t numTorn = 0;
+			size_t numDuplicated = 0;
+			size_t numOutOfOrder = 0;
+			size_t numForeign = 0; //lines that aren't ours (logger notices...), just counted
+			void setup(const string & name, int numThreads);
+			void check(const string & message);
+			size_t numLost(int recordsPerThread);
+			string describe(int recordsPerThread);
+		};
+
+		static string makeMessage(int thread, int index, size_t payloadLen);
+		static uint32_t checksum(const char * data, size_t len);
+		static string stripColors(const string & line); //terminal color escapes
+		static int redirectStdout(const string & path); //returns the saved stdout, -1 on failure
+		static void restoreStdout(int saved);
+
+		ofxSuperLog * logger = nullptr;
+		vector<std::thread> threads;
+		int numThreads = 0;
+		int recordsPerThread = 0;
+		std::atomic<int> numFinished{0};
+		std::atomic<size_t> numLogged{0};
+		std::atomic<size_t> numBytes{0};
+		uint64_t startTime = 0;
+		uint64_t endTime = 0;
+
+		std::mutex subscriptionMutex;
+		SinkCheck subscriptionCheck;
+		int subscriptionId = 0;
+
+		string consoleFile; //where stdout went, if checking the console
+		int savedStdout = -1;
+};
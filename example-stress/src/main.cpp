@@ -0,0 +1,22 @@
+#include "ofApp.h"
+
+// usage: example-stress [numThreads = 20] [recordsPerThread = 20000] [mode = plain|sync|ordered|uring] [logToConsole = 0]
+//
+// Hammers ofxSuperLog from many threads while the main thread toggles the screen log, clears it and draws it,
+// then checks every sink for lost, duplicated or torn records (the console too when logToConsole is 1; stdout goes to
+// data/stressConsole.txt meanwhile) and prints (and appends to data/stressResults.csv)
+// the throughput of the run. Exits with 1 if anything was wrong.
+//
+// To run it under ThreadSanitizer on Linux / OSX:
+//		make Debug PROJECT_CFLAGS=-fsanitize=thread PROJECT_LDFLAGS=-fsanitize=thread && make RunDebug
+
+int main(int argc, char ** argv){
+
+	ofSetupOpenGL(1024, 768, OF_WINDOW); //windowed, draw() is part of the test
+
+	ofApp * app = new ofApp();
+	for(int i = 1; i < argc; i++){
+		app->args.push_back(argv[i]);
+	}
+	ofRunApp(app);
+}
@@ -0,0 +1,49 @@
+#include "ofApp.h"
+
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+
+	if(args.size() > 0) numThreads = ofToInt(args[0]);
+	if(args.size() > 1) recordsPerThread = ofToInt(args[1]);
+	if(args.size() > 2) mode = args[2];
+	bool logToConsole = args.size() > 3 ? ofToInt(args[3]) != 0 : false;
+
+	ofSetLoggerChannel(ofxSuperLog::getLogger(logToConsole, true, "stressLogs"));
+	ofSetLogLevel(OF_LOG_VERBOSE);
+	ofxSuperLog::getLogger()->setMaximized(true);
+	ofxSuperLog::getLogger()->setFileLogShowsThreads(true);
+	ofxSuperLog::getLogger()->setHighResTimestamps(true);
+	if(mode == "sync") ofxSuperLog::getLogger()->setSyncronizedLogging(true);
+	if(mode == "ordered") ofxSuperLog::getLogger()->setOrderedLogging(true);
+	if(mode == "uring") ofxSuperLog::getLogger()->setFileIoUringEnabled(true); //plain logging, log file through io_uring
+
+	ofSetFrameRate(0);
+	ofSetVerticalSync(false);
+	test.start(ofxSuperLog::getLogger().get(), numThreads, recordsPerThread, logToConsole);
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+
+	//poke at the logger from the main thread while the workers are at it
+	auto & logger = ofxSuperLog::getLogger();
+	if(ofRandom(1) < 0.1) logger->setScreenLoggingEnabled(!logger->isScreenLoggingEnabled());
+	if(ofRandom(1) < 0.05) logger->getDisplayLogger().clearLog();
+
+	if(!test.isDone()) return;
+
+	StressTest::Results r = test.verify(mode);
+	cout << r.report << endl;
+
+	ofFile csv("stressResults.csv", ofFile::Append);
+	csv << ofGetTimestampString("%Y-%m-%d %H:%M:%S") << "," << mode << "," << numThreads << "," << r.numRecords << ","
+		<< r.seconds << "," << r.numRecords / r.seconds << "," << r.numBytes / r.seconds / (1024 * 1024) << "," << (r.ok ? "ok" : "FAILED") << endl;
+	ofExit(r.ok ? 0 : 1);
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	//the log panel draws itself after us while screen logging is enabled
+	ofDrawBitmapStringHighlight(ofToString(test.getNumLogged()) + " records logged", 20, 20);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxSuperLog.h"
+#include "StressTest.h"
+
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+
+		vector<string> args;
+		StressTest test;
+		int numThreads = 20;
+		int recordsPerThread = 20000;
+		string mode = "plain";
+};
@@ -9,6 +9,7 @@ void ofApp::setup(){
 	bool logToScreen = true;
 	
 	ofSetLoggerChannel(ofxSuperLog::getLogger(logToConsole, logToScreen, "logs"));
+	ofxSuperLog::setThreadName("main"); //how this thread shows up in the thread column, see setFileLogShowsThreads()
 
 	ofLogNotice() << "This is logging to your screen and ";
 	ofLogNotice() << "to a file with a timestamped file ";
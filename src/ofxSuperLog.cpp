@@ -19,11 +19,14 @@
 #include <cstdarg>
 
 ofPtr<ofxSuperLog> ofxSuperLog::logger;
+static const string emptyString;
 ofxSuperLog *ofxSuperLog::logPtr = NULL;
 
-ofPtr<ofxSuperLog> &ofxSuperLog::getLogger(bool writeToConsole, bool drawToScreen, string logDirectory) {
+#define SUPERLOG_EARLY_BUFFER_RECORDS 1024 //preallocated, grows if setup takes longer than that
+
+ofPtr<ofxSuperLog> &ofxSuperLog::getLogger(bool writeToConsole, bool drawToScreen, string logDirectory, bool deferSinkSetup) {
 	if(logPtr == NULL) {
-		logPtr = new ofxSuperLog(writeToConsole, drawToScreen, logDirectory);
+		logPtr = new ofxSuperLog(writeToConsole, drawToScreen, logDirectory, deferSinkSetup);
 		logger = ofPtr<ofxSuperLog>(logPtr);
 
 	}
@@ -53,13 +56,74 @@ RTL_OSVERSIONINFOW GetRealOSVersion() {
 }
 #endif
 
-ofxSuperLog::ofxSuperLog(bool writeToConsole, bool drawToScreen, string logDirectory) {
+namespace{
+	//per thread lines, reused so laying one out doesn't allocate once they've grown. Static destructors can
+	//still log once the main thread's thread_locals are destroyed; a temporary is used then
+	thread_local bool scratchGone = false; //trivially destructible, good until the thread is gone
+	struct ScratchLines{
+		string crash;
+		string console;
+		~ScratchLines(){scratchGone = true;}
+	};
+	thread_local ScratchLines scratch;
+}
+
+ofxSuperLog::ofxSuperLog(bool writeToConsole, bool drawToScreen, string logDirectory, bool deferSinkSetup) {
+
+	updateFormats();
+
+	this->loggingToFile = logDirectory!="";
+	this->loggingToScreen = drawToScreen;
+	this->loggingToConsole = writeToConsole;
+	this->logDirectory = logDirectory;
+	if(loggingToFile) {
+		#ifdef TARGET_WIN32
+		string fileName = ofGetTimestampString("%Y-%m-%d + %H-%M-%S + %A");
+		#else
+		string fileName = ofGetTimestampString("%Y-%m-%d | %H-%M-%S | %A");
+		#endif
+		currentLogFile = logDirectory + "/" + fileName + ".log";
+	}
+	if(drawToScreen) {
+		displayLogger.setEnabled(true);
+	}
+
+	if(deferSinkSetup){
+		earlyRecords.reserve(SUPERLOG_EARLY_BUFFER_RECORDS);
+		sinksReady = false;
+		sinkSetupThread = std::thread([this]{
+			ofxSuperLogThread::setName("ofxSuperLogSetup");
+			setupConsole();
+			setupSinks();
+			std::lock_guard<std::mutex> lock(earlyMutex); //log() calls wait here until the backlog is out
+			for(auto & r : earlyRecords){
+				writeToSinks(r.level, r.module, r.filteredModule, r.message, r.time, r.thread);
+			}
+			earlyRecords.clear();
+			earlyRecords.shrink_to_fit();
+			sinksReady = true;
+		});
+	}else{
+		setupConsole();
+		setupSinks();
+	}
+}
+
+void ofxSuperLog::setupConsole(){
+
+	//deferred, we're on the setup thread and the app may be setting us as the global channel right now:
+	//going through ofLog would race with that, so the notices go in with the early records
+	auto notice = [this](const string & msg){
+		if(sinksReady) ofLogNotice("ofxSuperLog") << msg;
+		else log(OF_LOG_NOTICE, "ofxSuperLog", msg);
+	};
+	bool color = false;
 
 	#ifdef TARGET_WIN32
 	
-	colorTerm = GetRealOSVersion().dwMajorVersion >= 10;
-	//colorTerm = IsWindows10OrGreater();
-	if (colorTerm) {
+	color = GetRealOSVersion().dwMajorVersion >= 10;
+	//color = IsWindows10OrGreater();
+	if (color) {
 		HANDLE hStdout;
 		DWORD handleMode;
 		hStdout = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -71,52 +135,49 @@ ofxSuperLog::ofxSuperLog(bool writeToConsole, bool drawToScreen, string logDirec
 	}
 	#else
 	if(const char* env_p = std::getenv("TERM")){ //see if term supports color!
-		ofLogNotice("ofxSuperLog") << "Your $TERM is: '" << env_p << "'";
+		notice("Your $TERM is: '" + string(env_p) + "'");
 		if(ofIsStringInString(string(env_p), "xterm")){
-			colorTerm = true;
+			color = true;
 		}
 	}
 	#endif
 
-	if(colorTerm) ofLogNotice("ofxSuperLog") << "Enabling colored console output";
+	if(color) notice("Enabling colored console output");
+	setLayout(colorTerm, color);
+}
 
-	this->loggingToFile = logDirectory!="";
-	this->loggingToScreen = drawToScreen;
-	this->loggingToConsole = writeToConsole;
-	this->logDirectory = logDirectory;
+void ofxSuperLog::setupSinks(){
 	if(loggingToFile) {
 		if(!ofFile(logDirectory).exists()) {
 			ofDirectory dir(logDirectory);
 			dir.create();
 		}
-		#ifdef TARGET_WIN32
-		string fileName = ofGetTimestampString("%Y-%m-%d + %H-%M-%S + %A");
-		#else
-		string fileName = ofGetTimestampString("%Y-%m-%d | %H-%M-%S | %A");
-		#endif
-		
-		currentLogFile = logDirectory + "/" + fileName + ".log";
 		fileLogger.setFile(currentLogFile, true);
+		ofxSuperLogClock::reanchor(); //new segment, new wall clock anchor
+		string module = filterModuleName("ofxSuperLog");
+		string anchor = ofxSuperLogClock::getAnchorDescription();
+		fileLogger.log(*fileFormat.load(), {OF_LOG_NOTICE, &module, &anchor, ofxSuperLogClock::now(), &ofxSuperLogThread::current()});
 	}
-	if(drawToScreen) {
-		displayLogger.setEnabled(true);
+}
+
+void ofxSuperLog::waitForSinks(){
+	if(sinkSetupThread.joinable() && sinkSetupThread.get_id() != std::this_thread::get_id()){
+		sinkSetupThread.join();
 	}
 }
 
 ofxSuperLog::~ofxSuperLog() {
+	waitForSinks();
+	backtraceSymbols.stop(); //records waiting for their backtrace go out now
+	orderedLogger.stop(); //written straight to the sinks from here on
 	 ofLogWarning("ofxSuperLog") << "~ofxSuperLog()"; 
+	#ifndef TARGET_WIN32
+	sharedRingCollector.stop();
+	socketLogger.close();
+	#endif
 }
 
 
-string ofxSuperLog::getEmojiForLogLevel(ofLogLevel level){
-	switch (level) {
-		case OF_LOG_WARNING: return "⚠️";
-		case OF_LOG_ERROR: return "‼️";
-		case OF_LOG_FATAL_ERROR: return "💣";
-  		default: return "";
-	}
-}
-
 //from https://stackoverflow.com/questions/61030383/how-to-convert-stdfilesystemfile-time-type-to-time-t
 template <typename TP>
 std::time_t to_time_t(TP tp){
@@ -170,58 +231,106 @@ void ofxSuperLog::setFont(ofxFontStash * font, float fontSiz){
 
 string ofxSuperLog::filterModuleName(const string & module){
 
-	if(module.size() > maxModuleLen) maxModuleLen = module.size();
-	string pad; pad.append(maxModuleLen - module.size(), ' ');
+	size_t len = maxModuleLen.load(std::memory_order_relaxed);
+	while(module.size() > len && !maxModuleLen.compare_exchange_weak(len, module.size(), std::memory_order_relaxed)){}
+	len = std::max(len, module.size());
+	string pad; pad.append(len - module.size(), ' ');
 	return pad + module;
 }
 
-void ofxSuperLog::log(ofLogLevel level, const string & module, const string & message) {
+void ofxSuperLog::log(ofLogLevel level, const string & module, const string & msg) {
+
+	if(backtraceLevel != OF_LOG_SILENT && level >= backtraceLevel){
+		ofxSuperLogBacktrace::Frames frames;
+		ofxSuperLogBacktrace::capture(frames, backtraceDepth, 1); //skip ourselves
+		string symbols;
+		if(!backtraceSymbols.trySymbolize(frames, symbols)){
+			//a call path we haven't seen yet: resolve it on the backtrace thread, the record goes out from there
+			uint64_t now = ofxSuperLogClock::now();
+			ofxSuperLogThread::Info thread = ofxSuperLogThread::current();
+			backtraceSymbols.symbolizeLater(frames, [this, level, module, msg, now, thread](const string & symbols){
+				logRecord(level, module, msg + "\n" + symbols, now, thread);
+			});
+			return;
+		}
+		logRecord(level, module, msg + "\n" + symbols, ofxSuperLogClock::now(), ofxSuperLogThread::current());
+		return;
+	}
+	logRecord(level, module, msg, ofxSuperLogClock::now(), ofxSuperLogThread::current());
+}
+
+void ofxSuperLog::logRecord(ofLogLevel level, const string & module, const string & message, uint64_t now,
+							const ofxSuperLogThread::Info & thread){
 
 	string filteredModName = filterModuleName(module);
-	string timeOfLog;
-	if(fileLogShowsTimestamps || consoleShowTimestamps){
-		timeOfLog = ofGetTimestampString("%Y/%m/%d %H:%M:%S");
+
+	subscriptions.push(level, module, message, now);
+	if(history.isEnabled()) history.push(level, module, message, now);
+
+	#ifndef TARGET_WIN32
+	if(crashHandler.isInstalled()){ //same layout as the log file
+		string temp;
+		string & crashLine = scratchGone ? temp : scratch.crash;
+		crashLine.clear();
+		fileFormat.load()->append(crashLine, {level, &filteredModName, &message, now, &thread});
+		crashHandler.record(crashLine);
+	}
+	#endif
+
+	auto makeRecord = [&]{
+		ofxSuperLogOrdered::Record r;
+		r.level = level;
+		r.time = now;
+		r.thread = thread;
+		r.module = module;
+		r.filteredModule = std::move(filteredModName);
+		r.message = message;
+		return r;
+	};
+
+	if(!sinksReady){
+		std::lock_guard<std::mutex> lock(earlyMutex);
+		if(!sinksReady){ //still setting up, keep it for later
+			earlyRecords.push_back(makeRecord());
+			return;
+		}
+	}
+
+	if(orderedLogger.isRunning()){
+		ofxSuperLogOrdered::Record r = makeRecord();
+		if(orderedLogger.push(std::move(r))) return;
+		writeToSinks(level, module, r.filteredModule, message, now, r.thread); //just stopped
+		return;
 	}
 
 	if(useMutex) syncLogMutex.lock();
-	
+	writeToSinks(level, module, filteredModName, message, now, thread);
+	if(useMutex) syncLogMutex.unlock();
+}
+
+void ofxSuperLog::writeToSinks(ofLogLevel level, const string & module, const string & filteredModName, const string & message,
+							   uint64_t now, const ofxSuperLogThread::Info & thread){
+
+	ofxSuperLogFormat::Fields fields = {level, &filteredModName, &message, now, &thread};
+
+	#ifndef TARGET_WIN32
+	if(loggingToSharedRing){
+		sharedRing.write(level, module, message);
+	}else if(loggingToSocket){
+		socketLogger.log(level, module, message);
+	}else
+	#endif
 	if(loggingToFile){
-		if(fileLogShowsTimestamps){
-			fileLogger.log(level, filteredModName, timeOfLog + " - " + message);
-		}else{
-			fileLogger.log(level, filteredModName, message);
-		}
+		fileLogger.log(*fileFormat.load(), fields);
 	}
-	if(loggingToScreen) displayLogger.log(level, filteredModName, message);
+	if(loggingToScreen) displayLogger.log(level, filteredModName, message, now, thread);
 	if(loggingToConsole){
-		string emojiIcon = "";
-		#if defined(TARGET_OSX) //sadly Xcode doesn't allow for colored console, but its really helpful to get warnings and errs to stand out
-								//so we use emoji for that (which work on OSX but not so much on win)
-		emojiIcon = getEmojiForLogLevel(level) + " ";
-		#endif
-		if(colorTerm){ //colorize term output
-			string colorMsg;
-			switch (level) {
-				case OF_LOG_VERBOSE: colorMsg = "\033[0;37m"; break; //gray
-				case OF_LOG_NOTICE: colorMsg = "\033[0;32m"; break; //green
-				case OF_LOG_WARNING: colorMsg = "\033[30;43m"; break; //yellow
-				case OF_LOG_ERROR: colorMsg = "\033[30;41m"; break; //red bg
-				case OF_LOG_FATAL_ERROR: colorMsg = "\033[30;45m"; break; //purple
-				default : break;
-			}
-			if(consoleShowTimestamps){
-				consoleLogger.log(level, filteredModName, emojiIcon + colorMsg + timeOfLog + " - " + message + "\033[0;0m");
-			}else{
-				consoleLogger.log(level, filteredModName, emojiIcon + colorMsg + message + "\033[0;0m");
-			}
-
-		}else{
-			if(consoleShowTimestamps){
-				consoleLogger.log(level, filteredModName, emojiIcon + timeOfLog + " - " + message);
-			}else{
-				consoleLogger.log(level, filteredModName, emojiIcon + message);
-			}
-		}
+		string temp;
+		string & consoleLine = scratchGone ? temp : scratch.console;
+		consoleLine.clear();
+		consoleFormat.load()->append(consoleLine, fields);
+		consoleLine += '\n';
+		writeToConsole(level, consoleLine);
 	}
 	/*
 	if(logToNotification){
@@ -304,7 +413,117 @@ void ofxSuperLog::log(ofLogLevel level, const string & module, const string & me
 
 	}
 #endif
+}
+
+void ofxSuperLog::updateFormats(){
 
+	std::lock_guard<std::mutex> lock(formatMutex); //the settings are read from here on
+
+	//defaults: same layout as ofFileLoggerChannel / ofConsoleLoggerChannel, plus time & thread columns
+	string time = highResTimestamps ? "%T.%us - " : "%T - ";
+	string file = filePattern;
+	if(file.empty()){
+		file = "[%L] %M: " + (fileLogShowsTimestamps ? time : "") + (fileLogShowsThreads ? "[%t] " : "") + "%m";
+	}
+	string console = consolePattern;
+	if(console.empty()){
+		#if defined(TARGET_OSX) //sadly Xcode doesn't allow for colored console, but its really helpful to get warnings and errs to stand out
+								//so we use emoji for that (which work on OSX but not so much on win)
+		console = "[%L] %M: %e%c";
+		#else
+		console = "[%L] %M: %c";
+		#endif
+		console += (consoleShowTimestamps ? time : "") + (consoleShowsThreads ? "[%t] " : "") + "%m%r";
+	}
+
+	fileFormat = findFormat(file, false);
+	consoleFormat = findFormat(console, colorTerm);
+}
+
+const ofxSuperLogFormat * ofxSuperLog::findFormat(const string & pattern, bool colors){
+	for(auto & f : formats){
+		if(f.getPattern() == pattern && f.hasColors() == colors) return &f;
+	}
+	formats.emplace_back(pattern, colors);
+	return &formats.back();
+}
+
+void ofxSuperLog::writeToConsole(ofLogLevel level, const string & text){
+	//like ofConsoleLoggerChannel: errors to stderr, the rest to stdout
+	ostream & stream = level >= OF_LOG_ERROR ? cerr : cout;
+	stream.write(text.data(), text.size());
+	stream.flush();
+}
+
+void ofxSuperLog::log(ofxSuperLogBatch & batch){
+
+	//ofLog checks the module's level before it gets to us, the batch doesn't go through ofLog
+	const string * levelModule = nullptr;
+	ofLogLevel moduleLevel = OF_LOG_VERBOSE;
+	batch.removeIf([&](const ofxSuperLogBatch::Line & l){
+		if(!levelModule || l.module != *levelModule){
+			levelModule = &l.module;
+			moduleLevel = ofGetLogLevel(l.module);
+		}
+		return l.level < moduleLevel;
+	});
+	if(batch.empty()) return;
+
+	//these sinks & features work record by record
+	bool oneByOne = !sinksReady || orderedLogger.isRunning() || loggingToSharedRing || loggingToSocket || bWindowsEventLoggingEnabled;
+	for(size_t i = 0; i < batch.size() && !oneByOne; i++){
+		oneByOne = backtraceLevel != OF_LOG_SILENT && batch[i].level >= backtraceLevel;
+	}
+	if(oneByOne){
+		for(size_t i = 0; i < batch.size(); i++) log(batch[i].level, batch[i].module, batch[i].message);
+		return;
+	}
+
+	//one timestamp for the whole batch, one lock per sink
+	uint64_t now = ofxSuperLogClock::now();
+	subscriptions.push(batch, now);
+	if(history.isEnabled()) history.push(batch, now);
+	const ofxSuperLogThread::Info & thread = ofxSuperLogThread::current();
+	const ofxSuperLogFormat & fileFmt = *fileFormat.load();
+	const ofxSuperLogFormat & consoleFmt = *consoleFormat.load();
+
+	for(size_t i = 0; i < batch.size(); i++){
+		ofxSuperLogBatch::Line & l = batch[i];
+		if(i == 0 || l.module != batch[i - 1].module){
+			l.filteredModule = filterModuleName(l.module);
+		}else{
+			l.filteredModule = batch[i - 1].filteredModule;
+		}
+		#ifndef TARGET_WIN32
+		if(crashHandler.isInstalled()){
+			string temp;
+			string & crashLine = scratchGone ? temp : scratch.crash;
+			crashLine.clear();
+			fileFmt.append(crashLine, {l.level, &l.filteredModule, &l.message, now, &thread});
+			crashHandler.record(crashLine);
+		}
+		#endif
+	}
+
+	if(useMutex) syncLogMutex.lock();
+	if(loggingToFile) fileLogger.log(batch, fileFmt, now, thread);
+	if(loggingToScreen) displayLogger.log(batch, now, thread);
+	if(loggingToConsole){
+		//one write per run of lines on the same stream
+		string temp;
+		string & out = scratchGone ? temp : scratch.console;
+		out.clear();
+		for(size_t i = 0; i < batch.size(); i++){
+			const ofxSuperLogBatch::Line & l = batch[i];
+			consoleFmt.append(out, {l.level, &l.filteredModule, &l.message, now, &thread});
+			out += '\n';
+			bool toErr = l.level >= OF_LOG_ERROR;
+			if(i + 1 == batch.size() || (batch[i + 1].level >= OF_LOG_ERROR) != toErr){
+				writeToConsole(l.level, out);
+				out.clear();
+			}
+		}
+	}
 	if(useMutex) syncLogMutex.unlock();
 }
 
@@ -319,6 +538,17 @@ void ofxSuperLog::setSyncronizedLogging(bool useMutex){
 	this->useMutex = useMutex;
 }
 
+void ofxSuperLog::setOrderedLogging(bool ordered){
+	if(ordered == orderedLogger.isRunning()) return;
+	if(ordered){
+		orderedLogger.start([this](const ofxSuperLogOrdered::Record & r){
+			writeToSinks(r.level, r.module, r.filteredModule, r.message, r.time, r.thread);
+		});
+	}else{
+		orderedLogger.stop(); //writes out whatever is still buffered
+	}
+}
+
 
 void ofxSuperLog::log(ofLogLevel logLevel, const string & module, const char* format, va_list args) {
 
@@ -347,6 +577,84 @@ void ofxSuperLog::setMaximized(bool maximized){
 	displayLogger.setMinimized(!maximized);
 }
 
+bool ofxSuperLog::setSharedMemoryLogging(const string & shmName, const string & sourceLabel, size_t ringBytes, int shmMode){
+#ifndef TARGET_WIN32
+	if(!sharedRing.create(shmName, sourceLabel, ringBytes, shmMode)){
+		ofLogError("ofxSuperLog") << "can't create shared memory log ring \"" << shmName << "\"";
+		return false;
+	}
+	ofLogNotice("ofxSuperLog") << "logging to shared memory ring \"" << shmName << "\" instead of the log file";
+	loggingToSharedRing = true;
+	return true;
+#else
+	ofLogNotice("ofxSuperLog") << "Shared memory logging is not available on Windows.";
+	return false;
+#endif
+}
+
+void ofxSuperLog::addSharedMemorySource(const string & shmName){
+#ifndef TARGET_WIN32
+	sharedRingCollector.addSource(shmName);
+	if(!collectingSharedRings){
+		collectingSharedRings = true;
+		sharedRingCollector.start([this](const string & source, const ofxSuperLogSharedRing::Record & r){
+			log(r.level, source + "/" + r.module, r.message);
+		});
+	}
+#else
+	ofLogNotice("ofxSuperLog") << "Shared memory logging is not available on Windows.";
+#endif
+}
+
+void ofxSuperLog::setSocketLogging(const string & socketPath, bool datagram, string spoolFile, size_t maxBatchBytes, int maxBatchMs, size_t maxSpoolBytes){
+#ifndef TARGET_WIN32
+	if(spoolFile.empty() && logDirectory.size()){
+		spoolFile = logDirectory + "/socketSpool.bin";
+	}
+	socketLogger.setup(socketPath, datagram, spoolFile, maxBatchBytes, maxBatchMs, maxSpoolBytes);
+	loggingToSocket = true;
+	ofLogNotice("ofxSuperLog") << "logging to socket \"" << socketPath << "\" instead of the log file";
+#else
+	ofLogNotice("ofxSuperLog") << "Socket logging is not available on Windows.";
+#endif
+}
+
+bool ofxSuperLog::setCrashDumpEnabled(bool enabled, size_t numRecords, string crashDirectory){
+#ifndef TARGET_WIN32
+	if(!enabled){
+		crashHandler.uninstall();
+		return true;
+	}
+	if(crashDirectory.empty()) crashDirectory = logDirectory;
+	if(crashDirectory.empty()){
+		ofLogError("ofxSuperLog") << "can't enable crash dumps: no log directory to write them to";
+		return false;
+	}
+	if(!ofDirectory::doesDirectoryExist(crashDirectory)){
+		ofDirectory::createDirectory(crashDirectory, true, true);
+	}
+	string path;
+	if(currentLogFile.size() && crashDirectory == logDirectory){
+		path = currentLogFile.substr(0, currentLogFile.size() - 4) + " CRASH.log"; //next to the log it belongs to
+	}else{
+		path = crashDirectory + "/" + ofGetTimestampString("%Y-%m-%d %H-%M-%S") + " CRASH.log";
+	}
+	return crashHandler.install(path, numRecords);
+#else
+	ofLogNotice("ofxSuperLog") << "Crash dumps are not available on Windows.";
+	return false;
+#endif
+}
+
+void ofxSuperLog::setBacktraceLevel(ofLogLevel level, int maxFrames){
+	backtraceLevel = level;
+	backtraceDepth = maxFrames;
+	if(level != OF_LOG_SILENT){ //the first backtrace() call loads the unwinder, get that out of the way now
+		ofxSuperLogBacktrace::Frames frames;
+		ofxSuperLogBacktrace::capture(frames, 1);
+	}
+}
+
 void ofxSuperLog::setWindowsEventLogging(bool _bEnabled, string _logName) {
 	
 #if defined(_WIN32) || defined(_WIN64)
@@ -373,12 +681,7 @@ std::string demangled_type_info_name(const std::type_info&ti) {
 	}
 	return r;
 #else
-	char demangleBuffer[512];
-	int status = 0;
-	size_t len = 4096;
-	abi::__cxa_demangle(ti.name(), (char*)&demangleBuffer, &len, &status);
-	//note theres no need to free the returned char* as we are providing our own buffer
-	string finalS = string(demangleBuffer);
+	string finalS = demangled_name(ti.name());
 	if (finalS.size() > 0) {
 		finalS = finalS.substr(0, finalS.size() - 1);
 	}
@@ -387,3 +690,18 @@ std::string demangled_type_info_name(const std::type_info&ti) {
 }
 
 
+std::string demangled_name(const char * mangledName) {
+
+#if defined(TARGET_OSX) || defined(TARGET_LINUX)
+	int status = 0;
+	char * demangled = abi::__cxa_demangle(mangledName, nullptr, nullptr, &status);
+	if (status == 0 && demangled) {
+		string r = demangled;
+		free(demangled);
+		return r;
+	}
+#endif
+	return mangledName;
+}
+
+
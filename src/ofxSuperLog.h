@@ -39,6 +39,15 @@
 #endif
 
 #include "ofxSuperLogDisplay.h"
+#include "ofxSuperLogFile.h"
+#include "ofxSuperLogSharedRing.h"
+#include "ofxSuperLogSocket.h"
+#include "ofxSuperLogCrashHandler.h"
+#include "ofxSuperLogBacktrace.h"
+#include "ofxSuperLogSubscriptions.h"
+#include "ofxSuperLogOrdered.h"
+#include "ofxSuperLogHistory.h"
+#include "ofxSuperLogFormat.h"
 
 #if defined(TARGET_OSX) || defined(TARGET_LINUX)
 #include <cxxabi.h>
@@ -59,11 +68,24 @@ class ofxSuperLog: public ofBaseLoggerChannel {
 
 public:
 
-	static ofPtr<ofxSuperLog> &getLogger(bool writeToConsole = true, bool drawToScreen = true, string logDirectory = "");
+	// deferSinkSetup: console probing, log directory creation & opening the log file happen on a background
+	// thread, so slow disks don't delay the first frame. Records logged meanwhile are kept and written in order
+	// once the sinks are ready.
+	static ofPtr<ofxSuperLog> &getLogger(bool writeToConsole = true, bool drawToScreen = true, string logDirectory = "", bool deferSinkSetup = false);
+
+	bool areSinksReady(){return sinksReady;}
+	void waitForSinks(); //blocks until deferred sink setup is done
 
 	// this affects the display only,  sets how many lines the scroll will have.
 	void setMaxNumLogLines(int maxNumLogLines);
 
+	// this affects the display only, caps the memory (in bytes) the scroll can hold. 0 for no limit.
+	void setMaxLogBytes(size_t maxBytes){ displayLogger.setMaxLogBytes(maxBytes); }
+	size_t getLogBytes(){ return displayLogger.getLogBytes(); }
+
+	// this affects the display only, keeps old scrollback compressed in memory. See ofxSuperLogDisplay::setCompressHistory()
+	void setCompressHistory(bool compress, size_t uncompressedLines = 2048){ displayLogger.setCompressHistory(compress, uncompressedLines); }
+
 	void setScreenLoggingEnabled(bool enabled);
 	bool isScreenLoggingEnabled();
 
@@ -73,6 +95,12 @@ public:
 	//probably big performance hit though!
 	void setSyncronizedLogging(bool useMutex);
 
+	//no mixed-up lines either, but without the mutex: records are handed to the file, console & screen
+	//from a single thread, in the order they were logged. Callers only pay for formatting and a buffer push.
+	void setOrderedLogging(bool ordered);
+	//waits until every record logged so far has been written, when using ordered logging
+	void flushOrderedLogging(){orderedLogger.flush();}
+
 	#ifdef USE_OFX_FONTSTASH
 	void setFont(ofxFontStash * font, float fontSiz);
 	#endif
@@ -80,7 +108,7 @@ public:
 	void setUseScreenColors(bool u){ displayLogger.setUseColors(u); }
 	void setColorForLogLevel(ofLogLevel l, const ofColor &c){ displayLogger.setColorForLogLevel(l, c); }
 	void setAutoDraw(bool autoDraw){displayLogger.setAutoDraw(autoDraw);}
-	void setColorTerm(bool color) { colorTerm = color;}
+	void setColorTerm(bool color) { setLayout(colorTerm, color);}
 
 	///this defines how much space the on-screen logging will take when the log is visible
 	///the panel is always on the right side. You must supply a % [0..1] of how much of the
@@ -93,6 +121,10 @@ public:
 
 	void log(ofLogLevel logLevel, const string & module, const char* format, va_list args);
 
+	// many records in one go: one timestamp, one lock, one write per sink. See ofxSuperLogBatch.
+	// Like ofLog, lines below ofGetLogLevel(module) are dropped; they are removed from the batch.
+	void log(ofxSuperLogBatch & batch);
+
 	virtual ~ofxSuperLog();
 
 	void draw(float w, float h);
@@ -101,11 +133,91 @@ public:
     
     ofxSuperLogDisplay& getDisplayLogger(){return displayLogger;}
 	
-	void setFileLogShowsTimestamps(bool t){fileLogShowsTimestamps = t;}
+	void setFileLogShowsTimestamps(bool t){setLayout(fileLogShowsTimestamps, t);}
+
+	//when does the log file get flushed to disk. N is lines for FLUSH_EVERY_N_LINES, ms for FLUSH_TIMED.
+	void setFileFlushPolicy(ofxSuperLogFile::FlushPolicy p, int n = 0){fileLogger.setFlushPolicy(p, n);}
+	//records >= level are flushed right away (and fdatasync'ed if sync), whatever the flush policy
+	void setFileFlushLevel(ofLogLevel level, bool sync = false){fileLogger.setFlushLevel(level, sync);}
+	//size of the log file write buffer; bigger buffers mean fewer writes, pair with setFileFlushLevel()
+	void setFileBufferSize(size_t bytes){waitForSinks(); fileLogger.setBufferSize(bytes);}
+	void flushLogFile(bool sync = false){fileLogger.flush(sync);}
+	//writes "<log file>.idx" next to the log, see ofxSuperLogFile::IndexEntry
+	void setFileIndexEnabled(bool enabled, uint32_t chunkBytes = 1024 * 1024){fileLogger.setIndexEnabled(enabled, chunkBytes);}
+	//flight recorder: only records >= persistLevel go to disk, the rest are kept in memory and written out
+	//(the last contextLines / contextSeconds of them, in at most ringBytes; contextSeconds 0 means no time limit)
+	//when a record >= triggerLevel comes in, along with the tailLines records after it. See ofxSuperLogFile::setFlightRecorder()
+	void setFileFlightRecorder(bool enabled, ofLogLevel persistLevel = OF_LOG_WARNING, ofLogLevel triggerLevel = OF_LOG_ERROR,
+							   size_t contextLines = 5000, float contextSeconds = 30, size_t tailLines = 200, size_t ringBytes = 4 * 1024 * 1024){
+		fileLogger.setFlightRecorder(enabled, persistLevel, triggerLevel, contextLines, contextSeconds, tailLines, ringBytes);
+	}
+	//Linux: write the log file through io_uring, so a busy disk never stalls the thread that logged.
+	//Falls back to the regular stdio file when io_uring isn't available. See ofxSuperLogFile::setIoUringEnabled()
+	bool setFileIoUringEnabled(bool enabled, size_t bufferBytes = 256 * 1024, int numBuffers = 4){
+		waitForSinks();
+		return fileLogger.setIoUringEnabled(enabled, bufferBytes, numBuffers); //reopens the file
+	}
 	
 	string getCurrentLogFile(){return currentLogFile;}
 
-	void setConsoleShouldShowTimestamps(bool c){consoleShowTimestamps = c;}
+	void setConsoleShouldShowTimestamps(bool c){setLayout(consoleShowTimestamps, c);}
+
+	// line layout for the log file / console, ie "%T.%ms [%L] %M: %m". See ofxSuperLogFormat for the tokens.
+	// An empty pattern goes back to the default layout, the one the timestamp & thread settings above control.
+	// tools/ofxSuperLogSearch filters and example-replay only understand the default file layout.
+	void setFileLogFormat(const string & pattern){setLayout(filePattern, pattern);}
+	void setConsoleLogFormat(const string & pattern){setLayout(consolePattern, pattern);}
+	string getFileLogFormat(){return fileFormat.load()->getPattern();}
+	string getConsoleLogFormat(){return consoleFormat.load()->getPattern();}
+
+	// adds a "[T3:threadName]" column. Name threads with ofxSuperLog::setThreadName() from the thread itself.
+	void setFileLogShowsThreads(bool t){setLayout(fileLogShowsThreads, t);}
+	void setConsoleShouldShowThreads(bool t){setLayout(consoleShowsThreads, t);}
+	void setDisplayShowsThreads(bool t){displayLogger.setDisplayThreads(t);}
+	static void setThreadName(const string & name){ofxSuperLogThread::setName(name);}
+
+	// adds microseconds to file & console timestamps. Timestamps come from a monotonic clock
+	// anchored to the wall clock once per log file, so they never jump with NTP adjustments.
+	void setHighResTimestamps(bool h){setLayout(highResTimestamps, h);}
+
+	// multi-process logging (not on Windows). Writers send their records to a named shared memory
+	// ring instead of their own log file; one collector instance merges all rings by timestamp
+	// into its own file & display. Records show up as "sourceLabel/module" on the collector.
+	// The ring is created with shmMode permissions, owner only by default; the collector must run as the same user.
+	bool setSharedMemoryLogging(const string & shmName, const string & sourceLabel, size_t ringBytes = 4 * 1024 * 1024, int shmMode = 0600);
+	void addSharedMemorySource(const string & shmName);
+
+	// send records to a collector daemon over a Unix-domain socket instead of the log file (not on Windows).
+	// Records are batched up to maxBatchBytes / maxBatchMs and sent from a background thread. While the
+	// collector is down they are spooled to spoolFile (defaults to logDirectory/socketSpool.bin), up to
+	// maxSpoolBytes; records past that are dropped. See tools/ofxSuperLogSocketCollector for a reference collector.
+	void setSocketLogging(const string & socketPath, bool datagram = false, string spoolFile = "",
+						  size_t maxBatchBytes = 16 * 1024, int maxBatchMs = 100, size_t maxSpoolBytes = 64 * 1024 * 1024);
+
+	// on SIGSEGV, SIGABRT, SIGBUS or SIGFPE, write the last numRecords log lines to a crash file
+	// next to the current log file (or in crashDirectory), then let the signal through (not on Windows).
+	bool setCrashDumpEnabled(bool enabled, size_t numRecords = 256, string crashDirectory = "");
+
+	// records at or above this level get the call stack that led to them appended (Linux & OSX).
+	// OF_LOG_SILENT (the default) disables it. Symbols are cached per address; a record whose call
+	// path has frames that aren't cached yet is symbolized and written from a background thread,
+	// so it may reach the sinks after records logged right after it (its timestamp is unchanged).
+	void setBacktraceLevel(ofLogLevel level, int maxFrames = 16);
+
+	// get batches of matching records on a dispatch thread. modules empty means all modules.
+	// returns an id for unsubscribe(). See ofxSuperLogSubscriptions.
+	int subscribe(ofxSuperLogSubscriptions::Callback cb, ofLogLevel minLevel = OF_LOG_VERBOSE, const vector<string> & modules = vector<string>()){
+		return subscriptions.subscribe(cb, minLevel, modules);
+	}
+	void unsubscribe(int id){subscriptions.unsubscribe(id);}
+	uint64_t getNumSubscriptionDrops(){return subscriptions.getNumDropped();}
+	// blocks until every record logged so far was handed to the subscribers
+	void flushSubscriptions(){subscriptions.flush();}
+
+	// keep the last numRecords records in memory, to query them with getHistory(). 0 (the default) disables it.
+	void setHistorySize(size_t numRecords){history.setMaxRecords(numRecords);}
+	// a snapshot of the in-memory history, oldest first. Narrow it down with last(), since() & filter().
+	ofxSuperLogHistory::Snapshot getHistory(){return history.getSnapshot();}
 
 	// Call at setup
 	void setWindowsEventLogging(bool _bEnabled, string _logName = "ofApp");
@@ -114,33 +226,91 @@ private:
 
 	static ofPtr<ofxSuperLog> logger;
 	static ofxSuperLog *logPtr;
-	ofxSuperLog(bool writeToConsole, bool drawToScreen, string logDirectory);
+	ofxSuperLog(bool writeToConsole, bool drawToScreen, string logDirectory, bool deferSinkSetup);
+
+	void setupConsole();
+	void setupSinks(); //log directory & file
+	std::thread sinkSetupThread;
+	std::atomic<bool> sinksReady{true};
+	std::mutex earlyMutex;
+	vector<ofxSuperLogOrdered::Record> earlyRecords; //logged before the sinks were ready
 
     string logDirectory;
 
 	bool loggingToFile;
 	bool loggingToScreen;
 	bool loggingToConsole;
-	ofConsoleLoggerChannel consoleLogger;
-	ofFileLoggerChannel fileLogger;
+	ofxSuperLogFile fileLogger;
 	ofxSuperLogDisplay displayLogger;
 
 	bool fileLogShowsTimestamps = true;
 	bool consoleShowTimestamps = false;
+	bool highResTimestamps = false;
+	bool fileLogShowsThreads = false;
+	bool consoleShowsThreads = false;
+
+	string filePattern; //set by the user, empty for the default layout
+	string consolePattern;
+	void updateFormats(); //recompiles both after any layout setting changes
+	template<typename T> void setLayout(T & setting, const T & value){ //the sink setup thread may be changing colorTerm
+		{
+			std::lock_guard<std::mutex> lock(formatMutex);
+			setting = value;
+		}
+		updateFormats();
+	}
+	std::atomic<const ofxSuperLogFormat*> fileFormat{nullptr};
+	std::atomic<const ofxSuperLogFormat*> consoleFormat{nullptr};
+	deque<ofxSuperLogFormat> formats; //every format ever compiled, a log() on another thread may still be using an old one.
+									  //Switching back to a pattern reuses its entry, so this only grows with distinct patterns.
+	const ofxSuperLogFormat * findFormat(const string & pattern, bool colors); //compiles it if it's new
+	std::mutex formatMutex; //formats & all the layout settings above, and colorTerm
+	void writeToConsole(ofLogLevel level, const string & text); //stdout, or stderr for errors
 	
 	string currentLogFile;
 	
 	string filterModuleName(const string &);
-	size_t maxModuleLen = 8; //len of the longest OF log module
+	std::atomic<size_t> maxModuleLen{8}; //len of the longest OF log module, log() runs on any thread
 	bool colorTerm = false;
 	
 	bool useMutex = false;
 	ofMutex syncLogMutex;
 
-	string getEmojiForLogLevel(ofLogLevel level);
+	//everything log() does once the message is final
+	void logRecord(ofLogLevel level, const string & module, const string & message, uint64_t now,
+				   const ofxSuperLogThread::Info & thread);
+
+	//file, console, screen & windows events
+	void writeToSinks(ofLogLevel level, const string & module, const string & filteredModName, const string & message,
+					  uint64_t now, const ofxSuperLogThread::Info & thread);
+	ofxSuperLogOrdered orderedLogger;
+
+	#ifndef TARGET_WIN32
+	ofxSuperLogSharedRing sharedRing; //writer side
+	ofxSuperLogSharedRingCollector sharedRingCollector;
+	bool collectingSharedRings = false;
+	#endif
+	bool loggingToSharedRing = false;
+
+	#ifndef TARGET_WIN32
+	ofxSuperLogSocket socketLogger;
+	#endif
+	bool loggingToSocket = false;
+
+	#ifndef TARGET_WIN32
+	ofxSuperLogCrashHandler crashHandler;
+	#endif
+
+	ofLogLevel backtraceLevel = OF_LOG_SILENT;
+	int backtraceDepth = 16;
+	ofxSuperLogBacktrace backtraceSymbols;
+
+	ofxSuperLogSubscriptions subscriptions;
+	ofxSuperLogHistory history;
 
 	bool bWindowsEventLoggingEnabled = false;
 	string windowsEventLoggingName = "ofApp"; // Should be the name of this app
 };
 
 std::string demangled_type_info_name(const std::type_info&ti);
+std::string demangled_name(const char * mangledName); //returns mangledName as is if it can't be demangled
@@ -0,0 +1,155 @@
+/**
+ *  ofxSuperLogBacktrace.cpp
+ *
+ */
+
+#include "ofxSuperLogBacktrace.h"
+#include "ofxSuperLog.h"
+#include "ofxSuperLogThread.h"
+
+#if defined(TARGET_OSX) || defined(TARGET_LINUX)
+	#include <execinfo.h>
+	#include <dlfcn.h>
+	#define SUPERLOG_HAS_BACKTRACE
+#endif
+
+void ofxSuperLogBacktrace::capture(Frames & frames, int maxFrames, int skipFrames){
+	#ifdef SUPERLOG_HAS_BACKTRACE
+	int skip = skipFrames + 1; //this function
+	int n = backtrace(frames.addr, std::min(maxFrames + skip, int(MAX_FRAMES)));
+	skip = std::min(skip, n);
+	memmove(frames.addr, frames.addr + skip, (n - skip) * sizeof(void*));
+	frames.num = n - skip;
+	#else
+	frames.num = 0;
+	#endif
+}
+
+ofxSuperLogBacktrace::~ofxSuperLogBacktrace(){
+	stop();
+}
+
+string ofxSuperLogBacktrace::symbolize(void * addr){
+	char addrStr[24];
+	snprintf(addrStr, sizeof(addrStr), "%p", addr);
+	#ifdef SUPERLOG_HAS_BACKTRACE
+	Dl_info info;
+	if(dladdr(addr, &info) && info.dli_fname){
+		string module = info.dli_fname;
+		size_t slash = module.find_last_of('/');
+		if(slash != string::npos) module = module.substr(slash + 1);
+		if(info.dli_sname){
+			char offset[24];
+			snprintf(offset, sizeof(offset), " + %lu", (unsigned long)((char*)addr - (char*)info.dli_saddr));
+			return module + "  " + demangled_name(info.dli_sname) + offset;
+		}
+		return module + "  " + addrStr;
+	}
+	#endif
+	return addrStr;
+}
+
+string ofxSuperLogBacktrace::symbolize(const Frames & frames){
+	//what isn't cached is resolved without holding the lock, trySymbolize() callers shouldn't wait for dladdr
+	vector<string> symbols(frames.num);
+	vector<int> missing;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(int i = 0; i < frames.num; i++){
+			auto it = cache.find(frames.addr[i]);
+			if(it != cache.end()) symbols[i] = it->second;
+			else missing.push_back(i);
+		}
+	}
+	for(int i : missing){
+		symbols[i] = symbolize(frames.addr[i]);
+	}
+	if(missing.size()){
+		std::lock_guard<std::mutex> lock(mutex);
+		for(int i : missing){
+			if(cache.size() >= maxCacheSize) cache.clear();
+			cache.emplace(frames.addr[i], symbols[i]);
+		}
+	}
+	string out;
+	for(int i = 0; i < frames.num; i++){
+		if(i > 0) out += "\n";
+		out += "#" + ofToString(i) + " " + symbols[i];
+	}
+	return out;
+}
+
+bool ofxSuperLogBacktrace::trySymbolize(const Frames & frames, string & out){
+	out.clear();
+	std::lock_guard<std::mutex> lock(mutex);
+	for(int i = 0; i < frames.num; i++){
+		auto it = cache.find(frames.addr[i]);
+		if(it == cache.end()) return false;
+		if(i > 0) out += "\n";
+		out += "#" + ofToString(i) + " " + it->second;
+	}
+	return true;
+}
+
+string ofxSuperLogBacktrace::formatAddresses(const Frames & frames){
+	string out;
+	for(int i = 0; i < frames.num; i++){
+		char addrStr[24];
+		snprintf(addrStr, sizeof(addrStr), "%p", frames.addr[i]);
+		if(i > 0) out += "\n";
+		out += "#" + ofToString(i) + " " + addrStr;
+	}
+	return out;
+}
+
+void ofxSuperLogBacktrace::symbolizeLater(const Frames & frames, Callback done){
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		if(pending.size() < maxPending){
+			if(!running){
+				running = true;
+				thread = std::thread(&ofxSuperLogBacktrace::threadedFunction, this);
+			}
+			pending.push_back({frames, std::move(done)});
+			condition.notify_one();
+			return;
+		}
+	}
+	done(formatAddresses(frames)); //way behind, better an unresolved stack than none
+}
+
+void ofxSuperLogBacktrace::stop(){
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		if(!running) return;
+		running = false;
+	}
+	condition.notify_all();
+	if(thread.joinable()) thread.join();
+}
+
+void ofxSuperLogBacktrace::threadedFunction(){
+	ofxSuperLogThread::setName("ofxSuperLogBacktrace");
+	std::unique_lock<std::mutex> lock(pendingMutex);
+	while(running || pending.size()){ //what was queued before stop() still goes out
+		if(pending.empty()){
+			condition.wait(lock);
+			continue;
+		}
+		Job job = std::move(pending.front());
+		pending.pop_front();
+		lock.unlock();
+		job.done(symbolize(job.frames));
+		lock.lock();
+	}
+}
+
+size_t ofxSuperLogBacktrace::getCacheSize(){
+	std::lock_guard<std::mutex> lock(mutex);
+	return cache.size();
+}
+
+void ofxSuperLogBacktrace::clearCache(){
+	std::lock_guard<std::mutex> lock(mutex);
+	cache.clear();
+}
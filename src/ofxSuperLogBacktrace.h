@@ -0,0 +1,74 @@
+/**
+ *  ofxSuperLogBacktrace.h
+ *
+ *  Description:
+ *				Call stack capture for ofxSuperLog. capture() only grabs raw return addresses
+ *				(a few microseconds); symbolize() turns them into text later, through a cache keyed
+ *				by address, so a repeated error from the same call path only pays for dladdr and
+ *				demangling once per frame.
+ *
+ *				trySymbolize() only looks at the cache; stacks with frames it hasn't seen yet go to
+ *				symbolizeLater(), which resolves them on its own thread, so the logging thread never
+ *				pays for dladdr and demangling. The cache holds at most maxCacheSize frames.
+ *
+ *				Linux and OSX only; capture() returns 0 frames elsewhere.
+ */
+
+#pragma once
+#include "ofMain.h"
+
+class ofxSuperLogBacktrace {
+public:
+
+	static const int MAX_FRAMES = 64;
+
+	struct Frames{
+		void * addr[MAX_FRAMES];
+		int num = 0;
+	};
+
+	///captures up to maxFrames return addresses, skipping the innermost skipFrames (capture() itself is always skipped)
+	static void capture(Frames & frames, int maxFrames, int skipFrames = 0);
+
+	typedef std::function<void(const string &)> Callback;
+
+	~ofxSuperLogBacktrace();
+
+	///one line per frame: "#3 libfoo.so  Foo::bar(int) + 42". Thread safe.
+	string symbolize(const Frames & frames);
+
+	///same as symbolize(), but only if every frame is already cached. Thread safe.
+	bool trySymbolize(const Frames & frames, string & out);
+
+	///symbolizes on a background thread and calls done from it. If too many are waiting,
+	///done gets the raw addresses right away. Thread safe.
+	void symbolizeLater(const Frames & frames, Callback done);
+
+	///runs what is waiting and stops the background thread
+	void stop();
+
+	size_t getCacheSize();
+	void clearCache();
+
+	size_t maxCacheSize = 4096; //frames; the cache starts over when full
+	size_t maxPending = 256; //stacks waiting for symbolizeLater()
+
+protected:
+
+	string symbolize(void * addr);
+	static string formatAddresses(const Frames & frames);
+	void threadedFunction();
+
+	std::unordered_map<void*, string> cache;
+	std::mutex mutex;
+
+	struct Job{
+		Frames frames;
+		Callback done;
+	};
+	std::deque<Job> pending;
+	std::mutex pendingMutex;
+	std::condition_variable condition;
+	std::thread thread;
+	bool running = false;
+};
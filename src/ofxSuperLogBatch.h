@@ -0,0 +1,57 @@
+/**
+ *  ofxSuperLogBatch.h
+ *
+ *  Description:
+ *				A group of records logged with a single ofxSuperLog::log(batch) call: one timestamp,
+ *				one lock, one append to the screen log and one write to the file & console.
+ *				Keep the batch around and clear() it between uses; its strings keep their capacity.
+ *
+ *  Usage:
+ *				batch.clear();
+ *				for(auto & d : devices) batch.add(OF_LOG_NOTICE, "devices", d.name + ": " + d.status);
+ *				ofxSuperLog::getLogger()->log(batch);
+ */
+
+#pragma once
+#include "ofMain.h"
+
+class ofxSuperLogBatch {
+public:
+
+	struct Line{
+		ofLogLevel level;
+		string module;
+		string message;
+		string filteredModule; //padded module, filled in by ofxSuperLog
+	};
+
+	void add(ofLogLevel level, const string & module, const string & message){
+		if(count == lines.size()) lines.push_back(Line());
+		Line & l = lines[count++];
+		l.level = level;
+		l.module = module;
+		l.message = message;
+	}
+
+	///drops the lines pred is true for, keeping the order of the rest (and the strings' capacity)
+	template<class Pred> void removeIf(Pred pred){
+		size_t kept = 0;
+		for(size_t i = 0; i < count; i++){
+			if(pred(lines[i])) continue;
+			if(i != kept) std::swap(lines[kept], lines[i]);
+			kept++;
+		}
+		count = kept;
+	}
+
+	void clear(){count = 0;}
+	size_t size() const {return count;}
+	bool empty() const {return count == 0;}
+	Line & operator[](size_t i){return lines[i];}
+	const Line & operator[](size_t i) const {return lines[i];}
+
+protected:
+
+	vector<Line> lines; //only the first count are in use
+	size_t count = 0;
+};
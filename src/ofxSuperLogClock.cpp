@@ -0,0 +1,69 @@
+/**
+ *  ofxSuperLogClock.cpp
+ *
+ */
+
+#include "ofxSuperLogClock.h"
+#include <time.h>
+
+std::atomic<int64_t> ofxSuperLogClock::wallOffset(0);
+std::atomic<bool> ofxSuperLogClock::anchored(false);
+
+void ofxSuperLogClock::reanchor(){
+	int64_t wall = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	wallOffset = wall - int64_t(now());
+	anchored = true;
+}
+
+string ofxSuperLogClock::getAnchorDescription(){
+	if(!anchored) reanchor();
+	uint64_t t = now();
+	return "clock anchor: " + formatWall(t, true) + " = " + formatSinceStart(t) + "s since start";
+}
+
+int64_t ofxSuperLogClock::toWallMicros(uint64_t t){
+	if(!anchored) reanchor();
+	return wallOffset.load(std::memory_order_relaxed) + int64_t(t);
+}
+
+string ofxSuperLogClock::formatWall(uint64_t t, bool micros){
+	int us;
+	const char * secs = formatWallSeconds(t, us);
+	if(!micros) return secs;
+	char buf[48];
+	snprintf(buf, sizeof(buf), "%s.%06d", secs, us);
+	return buf;
+}
+
+const char * ofxSuperLogClock::formatWallSeconds(uint64_t t, int & micros){
+	int64_t wall = toWallMicros(t);
+	time_t secs = wall / 1000000;
+	micros = int(wall % 1000000);
+
+	//most lines land within the same second as the previous one, skip strftime for those
+	static thread_local time_t lastSecs = -1;
+	static thread_local char lastStr[32];
+	if(secs != lastSecs){
+		struct tm tm;
+		#ifdef TARGET_WIN32
+		localtime_s(&tm, &secs);
+		#else
+		localtime_r(&secs, &tm);
+		#endif
+		strftime(lastStr, sizeof(lastStr), "%Y/%m/%d %H:%M:%S", &tm);
+		lastSecs = secs;
+	}
+	return lastStr;
+}
+
+string ofxSuperLogClock::formatSinceStart(uint64_t t){
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%llu.%06u", (unsigned long long)(t / 1000000), unsigned(t % 1000000));
+	return buf;
+}
+
+string ofxSuperLogClock::formatDelta(uint64_t t, uint64_t prevT){
+	char buf[32];
+	snprintf(buf, sizeof(buf), "+%lluus", (unsigned long long)(t >= prevT ? t - prevT : 0));
+	return buf;
+}
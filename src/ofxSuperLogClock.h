@@ -0,0 +1,52 @@
+/**
+ *  ofxSuperLogClock.h
+ *
+ *  Description:
+ *				Cheap monotonic timestamps for log records. now() reads steady_clock (the vDSO
+ *				CLOCK_MONOTONIC on linux, no syscall) so it never jumps with NTP adjustments.
+ *				Wall clock times are derived from a single anchor taken at the start of each
+ *				log segment (ie log file), and re-taken with reanchor().
+ */
+
+#pragma once
+#include "ofMain.h"
+
+class ofxSuperLogClock {
+public:
+
+	///microseconds since the clock was first used (app start, in practice).
+	static uint64_t now(){
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - getStart()).count();
+	}
+
+	///wall clock time for a now() value, "%Y/%m/%d %H:%M:%S", plus ".uuuuuu" if micros is true.
+	static string formatWall(uint64_t t, bool micros = false);
+
+	///same as formatWall(t) without allocating: the "%Y/%m/%d %H:%M:%S" part in a per thread
+	///buffer (valid until the next call on that thread), and the microseconds in micros
+	static const char * formatWallSeconds(uint64_t t, int & micros);
+
+	///wall clock microseconds since epoch for a now() value
+	static int64_t toWallMicros(uint64_t t);
+
+	///"12.345678" seconds since start
+	static string formatSinceStart(uint64_t t);
+
+	///"+1234us"
+	static string formatDelta(uint64_t t, uint64_t prevT);
+
+	///re-reads the wall clock; call when a new log segment starts.
+	static void reanchor();
+
+	///describes the current anchor, to be written at the start of a log segment.
+	static string getAnchorDescription();
+
+protected:
+
+	static std::chrono::steady_clock::time_point getStart(){
+		static std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		return start;
+	}
+	static std::atomic<int64_t> wallOffset; //wall clock us since epoch = wallOffset + now()
+	static std::atomic<bool> anchored;
+};
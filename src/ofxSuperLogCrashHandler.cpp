@@ -0,0 +1,184 @@
+/**
+ *  ofxSuperLogCrashHandler.cpp
+ *
+ */
+
+#include "ofxSuperLogCrashHandler.h"
+
+#ifndef TARGET_WIN32
+
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+ofxSuperLogCrashHandler * ofxSuperLogCrashHandler::instance = nullptr;
+
+static const int crashSignals[] = {SIGSEGV, SIGABRT, SIGBUS, SIGFPE};
+static const int numCrashSignals = sizeof(crashSignals) / sizeof(crashSignals[0]);
+static struct sigaction previousActions[numCrashSignals];
+static std::atomic<bool> dumping(false);
+
+static void writeStr(int fd, const char * s){
+	ssize_t r = write(fd, s, strlen(s));
+	(void)r;
+}
+
+static void writeInt(int fd, uint64_t v){ //no printf in signal handlers
+	char buf[24];
+	int i = sizeof(buf);
+	do{ buf[--i] = '0' + (v % 10); v /= 10; }while(v && i > 0);
+	ssize_t r = write(fd, buf + i, sizeof(buf) - i);
+	(void)r;
+}
+
+ofxSuperLogCrashHandler::~ofxSuperLogCrashHandler(){
+	uninstall();
+}
+
+bool ofxSuperLogCrashHandler::install(const string & path, size_t numRecords){
+	if(installed) uninstall(); //the ring stays, other threads may be recording into it
+	if(instance){
+		ofLogError("ofxSuperLogCrashHandler") << "there's already a crash handler installed";
+		return false;
+	}
+	string absPath = ofToDataPath(path, true);
+	if(absPath.size() >= sizeof(crashFilePath)){
+		ofLogError("ofxSuperLogCrashHandler") << "crash file path is too long: " << absPath;
+		return false;
+	}
+	strncpy(crashFilePath, absPath.c_str(), sizeof(crashFilePath));
+
+	numRecords = std::max(numRecords, size_t(1));
+	Ring * current = ring.load(std::memory_order_acquire);
+	if(!current || current->numSlots != numRecords){ //swapped in, never freed while we're around
+		Ring * r = new Ring();
+		r->numSlots = numRecords;
+		r->slots.reset(new Slot[numRecords]);
+		for(size_t i = 0; i < numRecords; i++){
+			r->slots[i].seq = 0;
+			r->slots[i].len = 0;
+		}
+		r->firstIdx = head.load(std::memory_order_acquire);
+		rings.push_back(unique_ptr<Ring>(r));
+		ring.store(r, std::memory_order_release);
+	}
+
+	setupThreadAltStack();
+
+	instance = this;
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = &ofxSuperLogCrashHandler::onSignal;
+	sa.sa_flags = SA_ONSTACK;
+	sigemptyset(&sa.sa_mask);
+	for(int i = 0; i < numCrashSignals; i++){
+		sigaction(crashSignals[i], &sa, &previousActions[i]);
+	}
+	installed = true;
+	return true;
+}
+
+void ofxSuperLogCrashHandler::uninstall(){
+	if(!installed) return;
+	for(int i = 0; i < numCrashSignals; i++){
+		sigaction(crashSignals[i], &previousActions[i], nullptr);
+	}
+	instance = nullptr;
+	installed = false;
+}
+
+namespace{
+	//own stack for the signal handler, so we can still dump after a stack overflow. sigaltstack() is per thread
+	struct ThreadAltStack{
+		vector<char> stack;
+		ThreadAltStack(){
+			stack_t current;
+			if(sigaltstack(nullptr, &current) == 0 && !(current.ss_flags & SS_DISABLE)) return; //the app set one up
+			stack.resize(std::max(size_t(SIGSTKSZ), size_t(64 * 1024)));
+			stack_t ss;
+			ss.ss_sp = stack.data();
+			ss.ss_size = stack.size();
+			ss.ss_flags = 0;
+			if(sigaltstack(&ss, nullptr) != 0) stack.clear();
+		}
+		~ThreadAltStack(){
+			if(stack.empty()) return;
+			stack_t ss;
+			memset(&ss, 0, sizeof(ss));
+			ss.ss_flags = SS_DISABLE;
+			sigaltstack(&ss, nullptr);
+		}
+	};
+}
+
+void ofxSuperLogCrashHandler::setupThreadAltStack(){
+	static thread_local ThreadAltStack altStack;
+	(void)altStack;
+}
+
+void ofxSuperLogCrashHandler::record(const string & line){
+	if(!installed.load(std::memory_order_acquire)) return;
+	setupThreadAltStack();
+	Ring * r = ring.load(std::memory_order_acquire);
+	uint64_t idx = head.fetch_add(1, std::memory_order_relaxed);
+	Slot & s = r->slots[idx % r->numSlots];
+	uint64_t prev = s.seq.load(std::memory_order_relaxed);
+	if(prev == SLOT_BUSY || !s.seq.compare_exchange_strong(prev, SLOT_BUSY, std::memory_order_acquire)){
+		return; //lapped a writer that's still at it, drop this one rather than tear both
+	}
+	std::atomic_thread_fence(std::memory_order_release);
+	size_t n = std::min(line.size(), SLOT_SIZE - 1); //truncated if need be, keep the newline
+	memcpy(s.text, line.data(), n);
+	s.text[n++] = '\n';
+	s.len = n;
+	s.seq.store(idx + 1, std::memory_order_release);
+}
+
+void ofxSuperLogCrashHandler::onSignal(int sig){
+	if(instance && !dumping.exchange(true)){
+		instance->dump(sig);
+	}
+	//hand the signal back to whoever had it before (usually the default action: core dump / exit)
+	for(int i = 0; i < numCrashSignals; i++){
+		if(crashSignals[i] == sig) sigaction(sig, &previousActions[i], nullptr);
+	}
+	raise(sig);
+}
+
+void ofxSuperLogCrashHandler::dump(int sig){
+	int fd = open(crashFilePath, O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if(fd < 0) return;
+
+	const char * sigName = "signal";
+	switch(sig){
+		case SIGSEGV: sigName = "SIGSEGV"; break;
+		case SIGABRT: sigName = "SIGABRT"; break;
+		case SIGBUS: sigName = "SIGBUS"; break;
+		case SIGFPE: sigName = "SIGFPE"; break;
+	}
+	writeStr(fd, "---- ofxSuperLog crash dump: ");
+	writeStr(fd, sigName);
+	writeStr(fd, " (");
+	writeInt(fd, sig);
+	writeStr(fd, "), last log records follow ----\n");
+
+	Ring * r = ring.load(std::memory_order_acquire);
+	uint64_t end = head.load(std::memory_order_acquire);
+	uint64_t start = end > r->numSlots ? end - r->numSlots : 0;
+	start = std::max(start, r->firstIdx);
+	for(uint64_t idx = start; idx < end; idx++){
+		Slot & s = r->slots[idx % r->numSlots];
+		if(s.seq.load(std::memory_order_acquire) != idx + 1){ //overwritten or mid-write
+			writeStr(fd, "[ ... record ");
+			writeInt(fd, idx);
+			writeStr(fd, " was being written ... ]\n");
+			continue;
+		}
+		ssize_t r = write(fd, s.text, s.len);
+		(void)r;
+	}
+	writeStr(fd, "---- end of crash dump ----\n");
+	close(fd);
+}
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ *  ofxSuperLogCrashHandler.h
+ *
+ *  Description:
+ *				Keeps the last N log records in a preallocated lock-free ring of fixed size slots,
+ *				and installs handlers for SIGSEGV, SIGABRT, SIGBUS and SIGFPE that write that ring
+ *				to a crash file and then re-raise the signal. The handler only uses async-signal-safe
+ *				calls (open / write / close / sigaction / raise), no allocation and no locks.
+ *
+ *				Each thread that logs gets its own signal stack (on its first record), so a stack
+ *				overflow on any of them can still be dumped.
+ *
+ *				Lines longer than the slot size are truncated.
+ *				Not available on Windows.
+ */
+
+#pragma once
+#include "ofMain.h"
+
+#ifndef TARGET_WIN32
+
+class ofxSuperLogCrashHandler {
+public:
+
+	static const size_t SLOT_SIZE = 512;
+
+	///allocates the ring and installs the signal handlers. Only one handler can be installed per process.
+	///Installing again with the same numRecords keeps the ring and its records; a different numRecords swaps
+	///in a new, empty ring of that size. The old ring is kept around (threads may still be writing into it),
+	///so don't resize it often.
+	bool install(const string & crashFilePath, size_t numRecords = 256);
+	void uninstall();
+	bool isInstalled(){return installed.load(std::memory_order_acquire);}
+
+	///lock free, call from any thread. line is already laid out (see ofxSuperLogFormat), without the newline.
+	void record(const string & line);
+
+	~ofxSuperLogCrashHandler();
+
+protected:
+
+	static const uint64_t SLOT_BUSY = ~uint64_t(0);
+
+	struct Slot{
+		std::atomic<uint64_t> seq; //SLOT_BUSY while being written, 0 if never written, else index + 1
+		uint32_t len;
+		char text[SLOT_SIZE];
+	};
+
+	struct Ring{
+		unique_ptr<Slot[]> slots;
+		size_t numSlots;
+		uint64_t firstIdx; //head when it was swapped in, older records went to the previous ring
+	};
+
+	static void onSignal(int sig);
+	void dump(int sig);
+	static void setupThreadAltStack(); //once per thread
+
+	std::atomic<Ring*> ring{nullptr}; //the current one, loaded once per record
+	vector<unique_ptr<Ring>> rings; //all of them, freed with the handler
+	std::atomic<uint64_t> head{0};
+
+	char crashFilePath[1024];
+	std::atomic<bool> installed{false};
+
+	static ofxSuperLogCrashHandler * instance;
+};
+
+#endif
@@ -5,12 +5,17 @@
  */
 
 #include "ofxSuperLogDisplay.h"
+#include "ofxSuperLogLZ.h"
 #ifdef USE_OFX_FONTSTASH
 	#include "ofxFontStash.h"
 #endif
 
 #include <cstdarg>
 
+#define LOG_LEVEL_UNCOUNTED 0x80 //in CompressedBlock::levels
+#define LOG_MAX_DECOMPRESSED_BLOCKS 4
+#define LOG_MAX_FILTER_CACHE_LINES 4096 //filtered lines from compressed blocks kept for drawing
+
 ofxSuperLogDisplay::ofxSuperLogDisplay() {
 	enabled = false;
 	minimized = true;
@@ -38,7 +43,8 @@ ofxSuperLogDisplay::ofxSuperLogDisplay() {
 	#ifdef USE_OFX_FONTSTASH
 	font = NULL;
 	#endif
-	logLines.push_back(LogLine("", "", OF_LOG_WARNING));
+	modules.push_back(Module()); //id 0, no module
+	resetLines();
 	
 	ofAddListener(ofEvents().keyPressed, this, &ofxSuperLogDisplay::onKeyPressed);
 }
@@ -72,12 +78,114 @@ void ofxSuperLogDisplay::onKeyPressed(ofKeyEventArgs & k){
 	if (k.key == OF_KEY_PAGE_UP) {
 		targetScrollY = ofClamp(targetScrollY - 100 * lineH, -maxScrollY, 0);
 	}
+	if (k.key == 'h') {
+		displayThreads ^= true;
+	}
 	if (k.key == 't') {
-		displayTimes ^= true;
+		timeDisplayMode = TimeDisplayMode((timeDisplayMode + 1) % (TIME_DELTA + 1));
 	}
 	if(k.key == 'c'){
 		clearLog();
 	}
+	if(k.key == 'w'){
+		wordWrap ^= true;
+	}
+	if(!enabled || minimized) return; //the filter keys are plain digits & letters, leave them to the app then
+	if(k.key >= '1' && k.key <= '5'){ //toggle verbose..fatal
+		setFilter(getFilterLevels() ^ (1 << (k.key - '1')), getFilterModules());
+	}
+	if(k.key == '0'){
+		filterModuleCycle = -1;
+		clearFilter();
+	}
+	if(k.key == 'm'){ //one module at a time, then all again
+		vector<string> names;
+		mutex.lock();
+		for(auto & m : modules){
+			if(m.trimmed.size() && std::find(names.begin(), names.end(), m.trimmed) == names.end()) names.push_back(m.trimmed);
+		}
+		mutex.unlock();
+		filterModuleCycle++;
+		if(filterModuleCycle >= (int)names.size()) filterModuleCycle = -1;
+		setFilter(getFilterLevels(), filterModuleCycle < 0 ? vector<string>() : vector<string>(1, names[filterModuleCycle]));
+	}
+}
+
+void ofxSuperLogDisplay::setFilter(uint8_t levelMask, const vector<string> & modules_){
+	mutex.lock();
+	filterModules = modules_;
+	filter.levelMask = levelMask & LOG_ALL_LEVELS;
+	filter.active = filter.levelMask != LOG_ALL_LEVELS || filterModules.size();
+	for(auto & m : modules){
+		m.inFilter = filterModules.empty() || std::find(filterModules.begin(), filterModules.end(), m.trimmed) != filterModules.end();
+	}
+	rebuildFilter();
+	mutex.unlock();
+	scrollY = targetScrollY = inertia = 0; //back to the newest line
+}
+
+bool ofxSuperLogDisplay::isFiltered(){
+	mutex.lock();
+	bool active = filter.active;
+	mutex.unlock();
+	return active;
+}
+
+uint8_t ofxSuperLogDisplay::getFilterLevels(){
+	mutex.lock();
+	uint8_t levels = filter.levelMask;
+	mutex.unlock();
+	return levels;
+}
+
+vector<string> ofxSuperLogDisplay::getFilterModules(){
+	mutex.lock();
+	vector<string> m = filterModules;
+	mutex.unlock();
+	return m;
+}
+
+void ofxSuperLogDisplay::rebuildFilter(){
+	filter.lineSeqs.clear();
+	filter.buckets.clear();
+	filter.firstSeq = filter.nextSeq = 0;
+	filterLineCache.clear();
+	if(!filter.active) return;
+	//the only full pass over the history, when the filter changes
+	uint64_t seq = firstLineSeq;
+	for(auto & b : compressedBlocks){
+		for(size_t i = 0; i < LOG_COMPRESSED_BLOCK_LINES; i++, seq++){
+			ofLogLevel level = ofLogLevel(b.levels[i] & ~LOG_LEVEL_UNCOUNTED);
+			if(passesFilter(level, b.moduleIds[i], b.levels[i] & LOG_LEVEL_UNCOUNTED ? 0 : 1)) addToFilter(seq, level);
+		}
+	}
+	for(size_t i = 0; i < lineRingCount; i++, seq++){
+		const LogLine & l = lineAt(i);
+		if(passesFilter(ofLogLevel(l.level), l.moduleId, l.length)) addToFilter(seq, ofLogLevel(l.level));
+	}
+}
+
+void ofxSuperLogDisplay::getFilteredLine(size_t pos, DrawLine & out){
+	size_t i = viewLine(pos);
+	if(i >= compressedBlocks.size() * LOG_COMPRESSED_BLOCK_LINES){ //uncompressed, cheap
+		getLine(i, out);
+		return;
+	}
+	//a sparse view can have each line on screen in a different block, more than the decompressed LRU holds.
+	//Compressed lines never change, so they're kept by seq # after the first time instead of decompressing every frame
+	uint64_t seq = firstLineSeq + i;
+	auto it = filterLineCache.find(seq);
+	if(it == filterLineCache.end()){
+		if(filterLineCache.size() >= LOG_MAX_FILTER_CACHE_LINES) filterLineCache.clear();
+		it = filterLineCache.emplace(seq, DrawLine()).first;
+		getLine(i, it->second);
+	}
+	out = it->second;
+}
+
+void ofxSuperLogDisplay::addToFilter(uint64_t lineSeq, ofLogLevel level){
+	filter.lineSeqs.push_back(lineSeq);
+	addToBuckets(filter.buckets, filter.nextSeq++, level, true);
 }
 
 void ofxSuperLogDisplay::setScrollPosition(float pct){
@@ -109,6 +217,305 @@ void ofxSuperLogDisplay::setMaxNumLogLines(int maxNumLogLines) {
 	MAX_NUM_LOG_LINES = maxNumLogLines;
 }
 
+void ofxSuperLogDisplay::setMaxLogBytes(size_t maxBytes) {
+	mutex.lock();
+	maxLogBytes = maxBytes;
+	while(maxLogBytes > 0 && logBytes > maxLogBytes && numLines() > 1) {
+		popOldest();
+	}
+	mutex.unlock();
+}
+
+size_t ofxSuperLogDisplay::getLogBytes() {
+	mutex.lock();
+	size_t b = logBytes;
+	mutex.unlock();
+	return b;
+}
+
+size_t ofxSuperLogDisplay::getNumLogLines() {
+	mutex.lock();
+	size_t n = numLines();
+	mutex.unlock();
+	return n;
+}
+
+void ofxSuperLogDisplay::getLines(vector<string> & lines) {
+	mutex.lock();
+	size_t n = numLines();
+	lines.resize(n);
+	DrawLine l;
+	for(size_t i = 0; i < n; i++){
+		getLine(i, l);
+		lines[i] = l.line;
+	}
+	mutex.unlock();
+}
+
+void ofxSuperLogDisplay::setCompressHistory(bool compress, size_t uncompressedLines) {
+	mutex.lock();
+	maxUncompressedLines = compress ? std::max(uncompressedLines, size_t(LOG_COMPRESSED_BLOCK_LINES)) : 0;
+	while(maxUncompressedLines && lineRingCount >= maxUncompressedLines + LOG_COMPRESSED_BLOCK_LINES){
+		sealOldestLines();
+	}
+	mutex.unlock();
+}
+
+size_t ofxSuperLogDisplay::numLines() {
+	return compressedBlocks.size() * LOG_COMPRESSED_BLOCK_LINES + lineRingCount;
+}
+
+void ofxSuperLogDisplay::getLine(size_t i, DrawLine & out) {
+	size_t numCompressed = compressedBlocks.size() * LOG_COMPRESSED_BLOCK_LINES;
+	const LogLine * l;
+	const char * text;
+	if(i >= numCompressed){
+		l = &lineAt(i - numCompressed);
+		text = getText(*l);
+	}else{
+		const DecompressedBlock & b = getDecompressedBlock(compressedBlocks[i / LOG_COMPRESSED_BLOCK_LINES]);
+		l = &b.lines[i % LOG_COMPRESSED_BLOCK_LINES];
+		text = b.text.data() + l->offset;
+	}
+	out.line.assign(text, l->length);
+	out.time = l->time;
+	out.thread = l->thread;
+	out.module = &modules[l->moduleId];
+	out.level = ofLogLevel(l->level);
+	out.seq = firstLineSeq + i;
+}
+
+uint16_t ofxSuperLogDisplay::getModuleId(const string & name) {
+	if(name.empty()) return 0;
+	auto it = moduleIds.find(name);
+	if(it != moduleIds.end()) return it->second;
+	if(modules.size() > UINT16_MAX) return 0; //that's a lot of modules, the rest go unnamed
+	Module m;
+	m.name = name;
+	m.label = name + ":";
+	size_t c = name.find_first_not_of(' ');
+	m.trimmed = c == string::npos ? "" : name.substr(c);
+	m.color = getColorForModule(m.trimmed);
+	m.inFilter = filterModules.empty() || std::find(filterModules.begin(), filterModules.end(), m.trimmed) != filterModules.end();
+	if(name.size() > maxModuleLen) maxModuleLen = name.size();
+	modules.push_back(m);
+	moduleIds[name] = modules.size() - 1;
+	return modules.size() - 1;
+}
+
+void ofxSuperLogDisplay::storeText(LogLine & l, const char * text, size_t len) {
+	if(arenaChunks.empty() || arenaChunks.back().size - arenaChunks.back().used < len){
+		if(spareChunks.size() && len <= LOG_ARENA_CHUNK_BYTES){
+			arenaChunks.push_back(std::move(spareChunks.back()));
+			spareChunks.pop_back();
+		}else{
+			ArenaChunk c;
+			c.size = std::max(len, size_t(LOG_ARENA_CHUNK_BYTES)); //very long lines get a chunk of their own
+			c.data.reset(new char[c.size]);
+			arenaChunks.push_back(std::move(c));
+		}
+		arenaChunks.back().used = 0;
+	}
+	ArenaChunk & c = arenaChunks.back();
+	l.chunk = firstChunkSeq + arenaChunks.size() - 1;
+	l.offset = c.used;
+	l.length = len;
+	if(len) memcpy(c.data.get() + c.used, text, len);
+	c.used += len;
+}
+
+void ofxSuperLogDisplay::releaseArenaChunks() {
+	if(arenaChunks.empty()) return;
+	uint32_t oldestInUse = lineRingCount ? lineAt(0).chunk : firstChunkSeq + arenaChunks.size() - 1;
+	while(firstChunkSeq < oldestInUse){
+		ArenaChunk & c = arenaChunks.front();
+		if(c.size == LOG_ARENA_CHUNK_BYTES && spareChunks.size() < 2){
+			spareChunks.push_back(std::move(c));
+		}
+		arenaChunks.pop_front();
+		firstChunkSeq++;
+	}
+}
+
+//serialized line: level u8 | time u64 | thread id u32 | thread name ptr | module id u16 | line len u32 | line
+template<typename T> static void put(vector<uint8_t> & buf, const T & v){
+	const uint8_t * p = (const uint8_t*)&v;
+	buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+template<typename T> static T get(const uint8_t *& p){
+	T v;
+	memcpy(&v, p, sizeof(T));
+	p += sizeof(T);
+	return v;
+}
+
+void ofxSuperLogDisplay::sealOldestLines() {
+	vector<uint8_t> raw;
+	CompressedBlock b;
+	b.levels.resize(LOG_COMPRESSED_BLOCK_LINES);
+	b.moduleIds.resize(LOG_COMPRESSED_BLOCK_LINES);
+	for(size_t i = 0; i < LOG_COMPRESSED_BLOCK_LINES; i++){
+		const LogLine & l = lineAt(i);
+		const char * text = getText(l);
+		put(raw, l.level);
+		put(raw, l.time);
+		put(raw, l.thread.id);
+		put(raw, l.thread.name);
+		put(raw, l.moduleId);
+		put(raw, l.length);
+		raw.insert(raw.end(), text, text + l.length);
+		b.levels[i] = l.level | (l.length ? 0 : LOG_LEVEL_UNCOUNTED);
+		b.moduleIds[i] = l.moduleId;
+		logBytes -= lineBytes(l);
+	}
+	lineRingHead = (lineRingHead + LOG_COMPRESSED_BLOCK_LINES) % lineRing.size();
+	lineRingCount -= LOG_COMPRESSED_BLOCK_LINES;
+	releaseArenaChunks();
+	ofxSuperLogLZ::compress(raw.data(), raw.size(), b.data);
+	b.data.shrink_to_fit();
+	b.rawSize = raw.size();
+	b.id = nextBlockId++;
+	b.numBytes = sizeof(CompressedBlock) + b.data.capacity() + b.levels.capacity() + b.moduleIds.capacity() * sizeof(uint16_t);
+	logBytes += b.numBytes;
+	compressedBlocks.push_back(std::move(b));
+}
+
+const ofxSuperLogDisplay::DecompressedBlock & ofxSuperLogDisplay::getDecompressedBlock(const CompressedBlock & b) {
+	for(auto it = decompressedBlocks.begin(); it != decompressedBlocks.end(); ++it){
+		if(it->id == b.id){
+			decompressedBlocks.splice(decompressedBlocks.begin(), decompressedBlocks, it);
+			return *it;
+		}
+	}
+	if(decompressedBlocks.size() >= LOG_MAX_DECOMPRESSED_BLOCKS){
+		decompressedBlocks.pop_back();
+	}
+	decompressedBlocks.emplace_front();
+	DecompressedBlock & d = decompressedBlocks.front();
+	d.id = b.id;
+	d.lines.resize(LOG_COMPRESSED_BLOCK_LINES);
+
+	vector<uint8_t> raw(b.rawSize);
+	if(!ofxSuperLogLZ::decompress(b.data.data(), b.data.size(), raw.data(), raw.size())){
+		const string corrupt = "<corrupt log block>";
+		d.text.assign(corrupt.begin(), corrupt.end());
+		for(auto & l : d.lines){
+			l = LogLine();
+			l.level = OF_LOG_ERROR;
+			l.length = corrupt.size();
+		}
+		return d;
+	}
+	d.text.reserve(b.rawSize);
+	const uint8_t * p = raw.data();
+	for(auto & l : d.lines){
+		l.level = get<uint8_t>(p);
+		l.time = get<uint64_t>(p);
+		l.thread.id = get<uint32_t>(p);
+		l.thread.name = get<const string*>(p);
+		l.moduleId = get<uint16_t>(p);
+		l.length = get<uint32_t>(p);
+		l.chunk = 0;
+		l.offset = d.text.size();
+		d.text.insert(d.text.end(), p, p + l.length);
+		p += l.length;
+	}
+	return d;
+}
+
+void ofxSuperLogDisplay::pushLine(ofLogLevel level, uint16_t moduleId, const char * text, size_t len, uint64_t time, const ofxSuperLogThread::Info & thread) {
+	addToBuckets(levelBuckets, nextLineSeq, level, len > 0); //the blank placeholder line doesn't count
+	if(filter.active && passesFilter(level, moduleId, len)) addToFilter(nextLineSeq, level);
+	nextLineSeq++;
+
+	if(lineRingCount == lineRing.size()){ //full, grow & unwrap
+		vector<LogLine> bigger(std::max(lineRing.size() * 2, size_t(1024)));
+		for(size_t i = 0; i < lineRingCount; i++) bigger[i] = lineAt(i);
+		lineRing.swap(bigger);
+		lineRingHead = 0;
+	}
+	LogLine & l = lineRing[(lineRingHead + lineRingCount) % lineRing.size()];
+	l.time = time;
+	l.thread = thread;
+	l.moduleId = moduleId;
+	l.level = level;
+	storeText(l, text, len);
+	lineRingCount++;
+	logBytes += lineBytes(l);
+}
+
+void ofxSuperLogDisplay::addToBuckets(deque<LevelBucket> & buckets, uint64_t seq, ofLogLevel level, bool counted) {
+	uint64_t bucket = seq / LOG_MINIMAP_BUCKET_LINES;
+	if(buckets.empty() || buckets.back().index != bucket){
+		buckets.push_back(LevelBucket());
+		buckets.back().index = bucket;
+	}
+	LevelBucket & b = buckets.back();
+	b.total++;
+	if(counted) b.counts[level]++;
+}
+
+void ofxSuperLogDisplay::removeOldestFromBuckets(deque<LevelBucket> & buckets, ofLogLevel level, bool counted) {
+	LevelBucket & b = buckets.front();
+	b.total--;
+	if(counted) b.counts[level]--;
+	if(b.total == 0) buckets.pop_front();
+}
+
+void ofxSuperLogDisplay::forgetLineStats(ofLogLevel level, bool counted) {
+	removeOldestFromBuckets(levelBuckets, level, counted);
+	if(filter.lineSeqs.size() && filter.lineSeqs.front() == firstLineSeq){ //was in the filtered view too
+		filter.lineSeqs.pop_front();
+		removeOldestFromBuckets(filter.buckets, level, true);
+		filter.firstSeq++;
+	}
+	firstLineSeq++;
+}
+
+void ofxSuperLogDisplay::popOldestLine() {
+	const LogLine & l = lineAt(0);
+	forgetLineStats(ofLogLevel(l.level), l.length > 0);
+	logBytes -= lineBytes(l);
+	lineRingHead = (lineRingHead + 1) % lineRing.size();
+	lineRingCount--;
+	releaseArenaChunks();
+}
+
+void ofxSuperLogDisplay::popOldest() {
+	if(compressedBlocks.empty()){
+		popOldestLine();
+		return;
+	}
+	const CompressedBlock & b = compressedBlocks.front();
+	for(uint8_t l : b.levels){
+		forgetLineStats(ofLogLevel(l & ~LOG_LEVEL_UNCOUNTED), !(l & LOG_LEVEL_UNCOUNTED));
+	}
+	logBytes -= b.numBytes;
+	compressedBlocks.pop_front();
+}
+
+void ofxSuperLogDisplay::resetLines() {
+	lineRingHead = lineRingCount = 0;
+	while(arenaChunks.size()){
+		if(arenaChunks.front().size == LOG_ARENA_CHUNK_BYTES && spareChunks.size() < 2){
+			spareChunks.push_back(std::move(arenaChunks.front()));
+		}
+		arenaChunks.pop_front();
+		firstChunkSeq++;
+	}
+	compressedBlocks.clear();
+	decompressedBlocks.clear();
+	levelBuckets.clear();
+	filter.lineSeqs.clear();
+	filter.buckets.clear();
+	filter.firstSeq = filter.nextSeq = 0;
+	filterLineCache.clear();
+	firstLineSeq = nextLineSeq;
+	logBytes = 0;
+	pushLine(OF_LOG_WARNING, 0, "", 0, ofxSuperLogClock::now(), ofxSuperLogThread::current());
+}
+
 void ofxSuperLogDisplay::setEnabled(bool enabled) {
 
 	if(enabled==this->enabled) return;
@@ -138,38 +545,55 @@ bool ofxSuperLogDisplay::isEnabled() {
 
 void ofxSuperLogDisplay::clearLog(){
 	mutex.lock();
-	logLines.clear();
-	logLines.push_back(LogLine("", "", OF_LOG_WARNING));
+	resetLines();
 	mutex.unlock();
 }
 
 void ofxSuperLogDisplay::log(ofLogLevel level, const string & module, const string & message) {
+	log(level, module, message, ofxSuperLogClock::now());
+}
+
+void ofxSuperLogDisplay::log(ofLogLevel level, const string & module, const string & message, uint64_t time) {
+	log(level, module, message, time, ofxSuperLogThread::current());
+}
+
+void ofxSuperLogDisplay::log(ofLogLevel level, const string & module, const string & message, uint64_t time, const ofxSuperLogThread::Info & thread) {
 
-	if(module.size() > maxModuleLen){
-		maxModuleLen = module.size();
-	}
 	mutex.lock();
-	if(message.find('\n') == -1) {
-		logLines.push_back(LogLine(module, message, level));
-	} else {
-		vector<string> lines = ofSplitString(message, "\n");
-		string emptyModName;
-		//emptyModName.append(maxModuleLen, ' ');
-
-		for(size_t i = 0; i < lines.size(); i++) {
-			if(i==0) {
-				logLines.push_back(LogLine(module, lines[0], level));
-			} else {
-				logLines.push_back(LogLine(module, lines[i], level));
-			}
-		}
-	}
-	while(logLines.size() > MAX_NUM_LOG_LINES) {
-		logLines.pop_front();
+	pushMessage(level, getModuleId(module), message, time, thread);
+	trimLines();
+	mutex.unlock();
+}
+
+void ofxSuperLogDisplay::log(const ofxSuperLogBatch & batch, uint64_t time, const ofxSuperLogThread::Info & thread) {
+	mutex.lock();
+	for(size_t i = 0; i < batch.size(); i++){
+		pushMessage(batch[i].level, getModuleId(batch[i].filteredModule), batch[i].message, time, thread);
 	}
+	trimLines(); //once for the lot
 	mutex.unlock();
 }
 
+void ofxSuperLogDisplay::pushMessage(ofLogLevel level, uint16_t moduleId, const string & message, uint64_t time, const ofxSuperLogThread::Info & thread) {
+	size_t start = 0;
+	while(true){ //one line per \n
+		size_t end = message.find('\n', start);
+		if(end == string::npos) end = message.size();
+		pushLine(level, moduleId, message.data() + start, end - start, time, thread);
+		if(end == message.size()) break;
+		start = end + 1;
+	}
+}
+
+void ofxSuperLogDisplay::trimLines() {
+	while(maxUncompressedLines && lineRingCount >= maxUncompressedLines + LOG_COMPRESSED_BLOCK_LINES) {
+		sealOldestLines();
+	}
+	while(numLines() > MAX_NUM_LOG_LINES || (maxLogBytes > 0 && logBytes > maxLogBytes && numLines() > 1)) {
+		popOldest();
+	}
+}
+
 
 void ofxSuperLogDisplay::log(ofLogLevel logLevel, const string & module, const char* format, ...) {
 	va_list args;
@@ -196,29 +620,27 @@ void ofxSuperLogDisplay::draw(float screenW, float screenH) {
 	lastW = screenW;
 	lastH = screenH;
 
-	deque<LogLine> linesCopy;
+	//only the lines that end up on screen are copied out (and decompressed if need be)
+	size_t numVisible = 0;
+	size_t linesCopyStart = 0; //index of linesCopy[0] in the whole history
+	size_t numLinesCopy;
+	deque<LevelBucket> bucketsCopy;
+	uint64_t firstSeq;
+	int firstPos = 0; //# of lines below the bottom edge of the screen
 
 	mutex.lock();
-	linesCopy = logLines;
-	mutex.unlock();
-
-	if(linesCopy.size() == 0) return;
+	numLinesCopy = viewSize(); //the filtered view, if any
+	size_t maxModuleLenCopy = maxModuleLen;
+	bucketsCopy = filter.active ? filter.buckets : levelBuckets;
+	firstSeq = filter.active ? filter.firstSeq : firstLineSeq;
+	bool filtered = filter.active;
 
-	ofPushStyle();
-	ofEnableAlphaBlending();
-	ofSetColor(bgColor);
-
-	if(minimized) {
-		minimizedRect.set(screenW - 150, screenH - 20, 150, 20);
-		ofDrawRectangle(minimizedRect);
-		ofSetColor(255);
-		ofDrawBitmapString("+ [ Log ] ", minimizedRect.x + 10, minimizedRect.getBottom() - 4);
-	} else {
+	if(!minimized && numLinesCopy > 0) {
 
 		dragSpeed *= 0.6;
 
-		//clamp scrolling to lines we own
-		maxScrollY = lineH * linesCopy.size() - screenH;
+		//clamp scrolling to lines we own, and the rows wrapping added at the top
+		maxScrollY = lineH * (numLinesCopy + (wordWrap ? wrapExtraRows : 0)) - screenH;
 		if(!scrolling){
 			float filter = 0.85f;
 			if(targetScrollY < -maxScrollY){
@@ -236,12 +658,39 @@ void ofxSuperLogDisplay::draw(float screenW, float screenH) {
 
 		scrollY = ofLerp(scrollY, targetScrollY, 0.33);
 
+		firstPos = ofClamp(floor((-scrollY - 20) / lineH) - 1, 0, numLinesCopy - 1);
+		int lastPos = ofClamp(ceil((screenH - scrollY) / lineH) + 1, 0, numLinesCopy - 1);
+		size_t newest = numLinesCopy - 1 - firstPos;
+		linesCopyStart = numLinesCopy - 1 - lastPos;
+		if(linesCopyStart > 0) linesCopyStart--; //one more, for time deltas
+		numVisible = newest - linesCopyStart + 1;
+		if(linesCopy.size() < numVisible) linesCopy.resize(numVisible);
+		for(size_t i = linesCopyStart; i <= newest; i++){
+			if(filtered) getFilteredLine(i, linesCopy[i - linesCopyStart]);
+			else getLine(i, linesCopy[i - linesCopyStart]);
+		}
+	}
+	mutex.unlock();
+
+	if(numLinesCopy == 0 && !filtered) return;
+
+	ofPushStyle();
+	ofEnableAlphaBlending();
+	ofSetColor(bgColor);
+
+	if(minimized) {
+		minimizedRect.set(screenW - 150, screenH - 20, 150, 20);
+		ofDrawRectangle(minimizedRect);
+		ofSetColor(255);
+		ofDrawBitmapString("+ [ Log ] ", minimizedRect.x + 10, minimizedRect.getBottom() - 4);
+	} else {
+
 		int x = screenW * (1. - widthPct);
 
 		ofDrawRectangle(x, 0, ceil(1 + screenW * widthPct), screenH);
 
 		if(!useColors) ofSetColor(200);
-		int pos = 0;
+		int pos = firstPos;
 
 		#ifdef USE_OFX_FONTSTASH
 		if(font) font->beginBatch();
@@ -249,16 +698,33 @@ void ofxSuperLogDisplay::draw(float screenW, float screenH) {
 
 		float yy;
 		bool drawn = false;
-		float postModuleX = int((maxModuleLen + 2.7) * charW); //
+		float postModuleX = int((maxModuleLenCopy + 2.7) * charW); //
 		const string separator = ":";
+		newestLineOnScreen = linesCopyStart;
 
-		for(int i = linesCopy.size() - 1; i >= 0; i--) {
-			string time = string(displayTimes ? (linesCopy[i].timeOfLog + " - ") : "");
+		//monospaced columns; with ofxFontStash, charW is the width of an 'M' so proportional fonts fit too
+		int wrapCols = std::max(1, int((screenW * widthPct - 20 - postModuleX) / charW));
+		if(wrapCols != wrapCacheCols){ //panel width or font size changed, lay out again as lines show up
+			wrapCache.clear();
+			wrapCacheCols = wrapCols;
+		}
+		int extraRows = 0;
+		int unreached = 0; //lines in linesCopy above the screen
+
+		for(int i = linesCopyStart + numVisible - 1; i >= (int)linesCopyStart; i--) {
+			const DrawLine & l = linesCopy[i - linesCopyStart];
+			const Module & m = *l.module;
+			string time = getTimeString(l, i > (int)linesCopyStart ? &linesCopy[i - linesCopyStart - 1] : nullptr);
+			const vector<uint32_t> * breaks = nullptr;
+			size_t rows = wordWrap ? getWrapRows(l, time.size() + separator.size(), wrapCols, breaks) : 1;
+			pos += rows - 1; //pos is now the line's first row, the others go below it
+			extraRows += rows - 1;
 			#ifdef USE_OFX_FONTSTASH
 			if(font){
 				yy = screenH - pos * lineH - scrollY;
-				if(yy < 0){
+				if(yy + (rows - 1) * lineH < 0){
 					newestLineOnScreen = i;
+					unreached = i;
 					break;
 				}
 				if(yy < screenH + 20){
@@ -266,20 +732,29 @@ void ofxSuperLogDisplay::draw(float screenW, float screenH) {
 						oldestLineOnScreen = i;
 						drawn = true;
 					}
-					if(linesCopy[i].module.size()){
-						if(useColors) ofSetColor(getColorForModule(linesCopy[i].moduleClean));
-						int off = charW * (maxModuleLen - linesCopy[i].module.size());
-						font->drawBatch(linesCopy[i].module + separator, fontSize, x + off + 22, yy - 5);
+					if(m.name.size()){
+						if(useColors) ofSetColor(m.color);
+						int off = charW * (maxModuleLenCopy - m.name.size());
+						font->drawBatch(m.label, fontSize, x + off + 22, yy - 5);
+					}
+					if(useColors) ofSetColor(logColors[l.level]);
+					if(!breaks){
+						font->drawBatch(time + l.line, fontSize, x + 16 + postModuleX, yy - 5);
+					}else{
+						font->drawBatch(time + l.line.substr(0, (*breaks)[0]), fontSize, x + 16 + postModuleX, yy - 5);
+						for(size_t r = 1; r < rows && yy + r * lineH < screenH + 20; r++){
+							size_t end = r < breaks->size() ? (*breaks)[r] : l.line.size();
+							font->drawBatch(l.line.substr((*breaks)[r - 1], end - (*breaks)[r - 1]), fontSize, x + 16 + postModuleX, yy + r * lineH - 5);
+						}
 					}
-					if(useColors) ofSetColor(logColors[linesCopy[i].level]);
-					font->drawBatch(time + linesCopy[i].line, fontSize, x + 16 + postModuleX, yy - 5);
 				}
 			}else
 			#endif
 			{
 				yy = screenH - pos * lineH - 5 - scrollY;
-				if(yy < 0){
+				if(yy + (rows - 1) * lineH < 0){
 					newestLineOnScreen = i;
+					unreached = i;
 					break;
 				}
 				if(yy < screenH + 20 ){
@@ -287,17 +762,33 @@ void ofxSuperLogDisplay::draw(float screenW, float screenH) {
 						oldestLineOnScreen = i;
 						drawn = true;
 					}
-					if(linesCopy[i].module.size()){
-						if(useColors) ofSetColor(getColorForModule(linesCopy[i].moduleClean));
-						int off = charW * (maxModuleLen - linesCopy[i].module.size());
-						ofDrawBitmapString(linesCopy[i].module + separator, x + off + 20, yy );
+					if(m.name.size()){
+						if(useColors) ofSetColor(m.color);
+						int off = charW * (maxModuleLenCopy - m.name.size());
+						ofDrawBitmapString(m.label, x + off + 20, yy );
+					}
+					if(useColors) ofSetColor(logColors[l.level]);
+					if(!breaks){
+						ofDrawBitmapString(separator + time + l.line, x + 20 + postModuleX, yy);
+					}else{
+						ofDrawBitmapString(separator + time + l.line.substr(0, (*breaks)[0]), x + 20 + postModuleX, yy);
+						for(size_t r = 1; r < rows && yy + r * lineH < screenH + 20; r++){
+							size_t end = r < breaks->size() ? (*breaks)[r] : l.line.size();
+							ofDrawBitmapString(l.line.substr((*breaks)[r - 1], end - (*breaks)[r - 1]), x + 20 + postModuleX + charW, yy + r * lineH);
+						}
 					}
-					if(useColors) ofSetColor(logColors[linesCopy[i].level]);
-					ofDrawBitmapString(separator + time + linesCopy[i].line, x + 20 + postModuleX, yy);
 				}
 			}
 			pos++;
 		}
+		if(wordWrap && linesCopyStart == 0){ //the top of the log was copied, count the rows wrapping adds above the screen too
+			for(int i = unreached - 1; i >= 0; i--){
+				const vector<uint32_t> * breaks = nullptr;
+				string time = getTimeString(linesCopy[i], i > 0 ? &linesCopy[i - 1] : nullptr);
+				extraRows += getWrapRows(linesCopy[i], time.size() + separator.size(), wrapCols, breaks) - 1;
+			}
+			wrapExtraRows = extraRows;
+		}
 
 		#ifdef USE_OFX_FONTSTASH
 		if(font)font->endBatch();
@@ -312,15 +803,17 @@ void ofxSuperLogDisplay::draw(float screenW, float screenH) {
 		ofDrawLine(x + 8, yy - 10, x+8, yy+10);
 		ofDrawLine(x+12, yy - 10, x+12, yy+10);
 		ofDrawBitmapString("x", screenW - screenW * widthPct + 6, screenH - 5);
+		drawMinimap(bucketsCopy, firstSeq, numLinesCopy, x, sepBarW, pad, screenH);
 		ofSetColor(0,0,0);
-		float y1 = ofMap(oldestLineOnScreen, 1, linesCopy.size(), pad, screenH, true);
-		float y2 = ofMap(newestLineOnScreen, 1, linesCopy.size(), pad, screenH, true);
+		float y1 = ofMap(oldestLineOnScreen, 1, numLinesCopy, pad, screenH, true);
+		float y2 = ofMap(newestLineOnScreen, 1, numLinesCopy, pad, screenH, true);
 		ofSetColor(255,64);
 		ofDrawRectangle(x + pad, y1, sepBarW - 2 * pad, y2 - y1);
 		ofPushMatrix();
 		ofTranslate(x, screenH - 18);
 		ofRotateDeg(-90, 0, 0, 1);
-		string helpMsg = "'t' to show log times  'c' to clear log.";
+		string helpMsg = "'t' to cycle log times  'h' to show threads  'c' to clear log  '1'-'5' & 'm' to filter  'w' to wrap.";
+		if(filtered) helpMsg = "[filtered: " + ofToString(numLinesCopy) + " lines, '0' to show all]  " + helpMsg;
 		#ifdef USE_OFX_FONTSTASH
 		if(font){
 			ofSetColor(0);
@@ -344,18 +837,80 @@ void ofxSuperLogDisplay::draw(float screenW, float screenH) {
 }
 
 
-const ofColor& ofxSuperLogDisplay::getColorForModule(const string & modName){
-	auto search = moduleColors.find(modName);
-	if(search == moduleColors.end()){
-		size_t sum = 0;
-		for(size_t i = 0; i < modName.size(); i++){
-			sum += modName[i];
+void ofxSuperLogDisplay::drawMinimap(const deque<LevelBucket> & buckets, uint64_t firstSeq, size_t numLines, float x, float w, float pad, float h){
+	int lastRow = -1;
+	ofLogLevel lastLevel = OF_LOG_VERBOSE;
+	for(auto & b : buckets){
+		ofLogLevel level = b.counts[OF_LOG_FATAL_ERROR] ? OF_LOG_FATAL_ERROR : b.counts[OF_LOG_ERROR] ? OF_LOG_ERROR :
+						   b.counts[OF_LOG_WARNING] ? OF_LOG_WARNING : OF_LOG_VERBOSE;
+		if(level == OF_LOG_VERBOSE) continue;
+		uint64_t first = std::max(b.index * LOG_MINIMAP_BUCKET_LINES, firstSeq) - firstSeq;
+		float y1 = ofMap(first, 1, numLines, pad, h, true);
+		float y2 = ofMap(first + b.total, 1, numLines, pad, h, true);
+		if(int(y1) == lastRow && level <= lastLevel) continue; //already marked this pixel row with something as bad
+		ofSetColor(logColors[level]);
+		ofDrawRectangle(x + 1, y1, w - 2, std::max(1.0f, y2 - y1));
+		lastRow = int(y1);
+		lastLevel = level;
+	}
+}
+
+string ofxSuperLogDisplay::getTimeString(const DrawLine & l, const DrawLine * prev){
+	string thread;
+	if(displayThreads) thread = "[" + ofxSuperLogThread::getTag(l.thread) + "] ";
+	switch(timeDisplayMode){
+		case TIME_WALL: return ofxSuperLogClock::formatWall(l.time) + " - " + thread;
+		case TIME_SINCE_START: return ofxSuperLogClock::formatSinceStart(l.time) + " - " + thread;
+		case TIME_DELTA: return ofxSuperLogClock::formatDelta(l.time, prev ? prev->time : l.time) + " - " + thread;
+		default: return thread;
+	}
+}
+
+size_t ofxSuperLogDisplay::getWrapRows(const DrawLine & l, size_t prefix, int cols, const vector<uint32_t> * & breaks){
+	if(prefix + l.line.size() <= size_t(cols)) return 1; //fits, bytes are never fewer than chars. Most lines go this way
+	auto it = wrapCache.find(l.seq);
+	if(it == wrapCache.end() || it->second.prefix != prefix){ //new on screen, or the time column changed
+		if(wrapCache.size() >= LOG_WRAP_CACHE_LINES) wrapCache.clear();
+		WrapLayout & w = wrapCache[l.seq];
+		w.prefix = prefix;
+		wrapText(l.line, cols > int(prefix) ? cols - prefix : 0, cols, w.breaks);
+		it = wrapCache.find(l.seq);
+	}
+	if(it->second.breaks.empty()) return 1; //long in bytes, but not in chars
+	breaks = &it->second.breaks;
+	return breaks->size() + 1;
+}
+
+void ofxSuperLogDisplay::wrapText(const string & text, size_t firstCols, size_t cols, vector<uint32_t> & breaks){
+	breaks.clear();
+	size_t rowStart = 0;
+	size_t rowCols = firstCols;
+	size_t col = 0; //chars in the row so far
+	size_t afterSpace = 0; //last place in the row we can break at without splitting a word
+	for(size_t i = 0; i < text.size(); i++){
+		if((text[i] & 0xC0) == 0x80) continue; //utf8 continuation byte, same char
+		if(col >= rowCols){ //char i goes on the next row
+			size_t b = afterSpace > rowStart ? afterSpace : i; //words longer than a row are cut
+			breaks.push_back(b);
+			rowStart = b;
+			rowCols = cols;
+			col = 0;
+			for(size_t j = b; j < i; j++){
+				if((text[j] & 0xC0) != 0x80) col++;
+			}
 		}
-		ofColor c; c.setHsb((sum)%255, 255, 255);
-		moduleColors[modName] = c;
-		return moduleColors[modName];
+		if(text[i] == ' ') afterSpace = i + 1;
+		col++;
+	}
+}
+
+ofColor ofxSuperLogDisplay::getColorForModule(const string & modName){
+	size_t sum = 0;
+	for(size_t i = 0; i < modName.size(); i++){
+		sum += modName[i];
 	}
-	return search->second;
+	ofColor c; c.setHsb((sum)%255, 255, 255);
+	return c;
 }
 
 
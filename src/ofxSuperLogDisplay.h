@@ -17,7 +17,16 @@
 
 #pragma once
 #include "ofMain.h"
+#include "ofxSuperLogClock.h"
+#include "ofxSuperLogThread.h"
+#include "ofxSuperLogBatch.h"
+#include <list>
 #define DEFAULT_NUM_LOG_LINES 4096
+#define LOG_MINIMAP_BUCKET_LINES 64 //lines per level counter bucket in the scrollbar minimap
+#define LOG_COMPRESSED_BLOCK_LINES 256 //lines per compressed scrollback block
+#define LOG_ARENA_CHUNK_BYTES (64 * 1024) //line text is stored in chunks of this size
+#define LOG_ALL_LEVELS 0x1F //filter level mask, verbose to fatal
+#define LOG_WRAP_CACHE_LINES 16384 //wrapped line layouts kept around before starting over
 
 #if defined(__has_include) /*llvm only - query about header files being available or not*/
 	#if __has_include("ofxFontStash.h") && !defined(DISABLE_AUTO_FIND_FONSTASH_HEADERS)
@@ -38,6 +47,21 @@ public:
 	virtual ~ofxSuperLogDisplay();
 	
 	void setMaxNumLogLines(int maxNumLogLines);
+
+	///caps the memory held by the scrollback, in bytes. 0 means no byte limit (the default).
+	///oldest lines are dropped when either this or the line limit is exceeded.
+	void setMaxLogBytes(size_t maxBytes);
+	size_t getMaxLogBytes(){return maxLogBytes;}
+	size_t getLogBytes(); //bytes currently held by the scrollback
+	size_t getNumLogLines();
+	///copies out the text of every line in the log, oldest first. Decompresses the whole history, not for every frame.
+	void getLines(vector<string> & lines);
+
+	///keeps only the newest uncompressedLines as regular lines, older history is sealed into
+	///compressed blocks of LOG_COMPRESSED_BLOCK_LINES and decompressed on demand when scrolled into.
+	///Use with a large setMaxNumLogLines() for long scrollback on little memory. Off by default.
+	void setCompressHistory(bool compress, size_t uncompressedLines = 2048);
+
 	void setEnabled(bool enabled);
 	bool getEnabled(){return enabled;}
 	void setAutoDraw(bool d){ autoDraw = d;}
@@ -50,13 +74,28 @@ public:
 	void clearLog();
 
 	void setUseColors(bool useC){useColors = useC;};
-	void setDisplayLogTimes(bool display) { displayTimes = display; }
+	enum TimeDisplayMode{
+		TIME_HIDDEN,
+		TIME_WALL,			//date & time of each line
+		TIME_SINCE_START,	//seconds since app start, us resolution
+		TIME_DELTA			//us elapsed since the previous line
+	};
+
+	void setDisplayLogTimes(bool display) { timeDisplayMode = display ? TIME_WALL : TIME_HIDDEN; }
+	void setTimeDisplayMode(TimeDisplayMode m){ timeDisplayMode = m; }
+	TimeDisplayMode getTimeDisplayMode(){ return timeDisplayMode; }
+	void setDisplayThreads(bool display){ displayThreads = display; } //"[T3:threadName]" column
 	void setColorForLogLevel(ofLogLevel l, const ofColor &c){ logColors[l] = c;}
 
 	///this defines how much space the on-screen logging will take when the log is visible
 	///the panel is always on the right side. You must supply a % [0..1] of how much of the
 	///whole screen the panel takes.
 	void setPanelWidth(float pct){widthPct = pct;}
+
+	///soft wraps long lines to the panel width instead of letting them run off the edge. Off by default, 'w' toggles it.
+	///Wrap points are worked out when a line first scrolls into view and kept until the panel width or font size changes.
+	void setWordWrap(bool wrap){wordWrap = wrap;}
+	bool getWordWrap(){return wordWrap;}
 	
 	#ifdef USE_OFX_FONTSTASH
 	void setFont(ofxFontStash* f, float fontSize_ = 16.0f);
@@ -72,8 +111,22 @@ public:
 	void log(ofLogLevel level, const string & module, const string & message);
 	void log(ofLogLevel logLevel, const string & module, const char* format, ...);
 	void log(ofLogLevel logLevel, const string & module, const char* format, va_list args);
+	void log(ofLogLevel level, const string & module, const string & message, uint64_t time); //time from ofxSuperLogClock::now()
+	void log(ofLogLevel level, const string & module, const string & message, uint64_t time, const ofxSuperLogThread::Info & thread); //on behalf of another thread
+	void log(const ofxSuperLogBatch & batch, uint64_t time, const ofxSuperLogThread::Info & thread); //uses the filtered modules
 
 	void setScrollPosition(float pct);
+
+	///filter view: only lines with a level in levelMask (bit 1 << level) and from one of modules (unpadded
+	///names, all if empty). The view is kept up to date as lines come & go, so scrolling it costs the same
+	///as scrolling the whole log. Keys (while the display is open): '1'..'5' toggle verbose..fatal,
+	///'m' cycles through single modules, '0' shows everything again.
+	void setFilter(uint8_t levelMask, const vector<string> & modules = vector<string>());
+	void setFilterMinLevel(ofLogLevel minLevel){setFilter(LOG_ALL_LEVELS & ~((1 << minLevel) - 1), getFilterModules());}
+	void clearFilter(){setFilter(LOG_ALL_LEVELS);}
+	bool isFiltered();
+	uint8_t getFilterLevels();
+	vector<string> getFilterModules(); //a copy, lines are filtered from other threads
 	
 protected:
 
@@ -82,34 +135,137 @@ protected:
 	
 	void draw(ofEventArgs &e);
 
+	//fixed size line record, the text lives in the arena. No per line heap allocations.
 	struct LogLine{
+		uint64_t time; //ofxSuperLogClock::now()
+		ofxSuperLogThread::Info thread;
+		uint32_t chunk; //arena chunk seq # (or 0 in a decompressed block)
+		uint32_t offset; //in the chunk
+		uint32_t length;
+		uint16_t moduleId; //index in modules
+		uint8_t level;
+	};
+
+	struct Module{
+		string name; //padded, as it came in
+		string label; //name + ":"
+		string trimmed; //name without the padding
+		ofColor color;
+		bool inFilter = true; //passes the filter's module list
+	};
+	deque<Module> modules; //never shrinks so addresses stay valid, 0 is the empty module
+
+	//a line copied out for drawing, strings are reused frame to frame
+	struct DrawLine{
 		string line;
-		string module;
-		string moduleClean;
-		string timeOfLog;
+		uint64_t time;
+		ofxSuperLogThread::Info thread;
+		const Module * module;
 		ofLogLevel level;
-		LogLine(const string & modName, const string & lin, ofLogLevel lev){
-			line = lin; module = modName, level = lev;
-			timeOfLog = ofGetTimestampString("%Y/%m/%d %H:%M:%S");
-			int c = 0;
-			for(auto it : modName){
-				if(it != ' ') break;
-				c++;
-			}
-			moduleClean = modName.substr(c, modName.size() - c);
-		}
+		uint64_t seq; //line sequence #
+	};
+	std::unordered_map<string, uint16_t> moduleIds;
+	uint16_t getModuleId(const string & name);
+
+	//text arena: lines are appended to the newest chunk, whole chunks are recycled once their lines are gone
+	struct ArenaChunk{
+		unique_ptr<char[]> data;
+		uint32_t size;
+		uint32_t used;
+	};
+	deque<ArenaChunk> arenaChunks;
+	uint32_t firstChunkSeq = 0; //seq # of arenaChunks.front()
+	vector<ArenaChunk> spareChunks;
+	void storeText(LogLine & l, const char * text, size_t len);
+	const char * getText(const LogLine & l){ return arenaChunks[l.chunk - firstChunkSeq].data.get() + l.offset; }
+	void releaseArenaChunks(); //the ones older than the oldest line
+
+	//ring of uncompressed lines, oldest first. Grows when full, never shrinks
+	vector<LogLine> lineRing;
+	size_t lineRingHead = 0;
+	size_t lineRingCount = 0;
+	LogLine & lineAt(size_t i){ return lineRing[(lineRingHead + i) % lineRing.size()]; }
+	static size_t lineBytes(const LogLine & l){ return sizeof(LogLine) + l.length; }
+
+	//all these need the mutex locked
+	void pushMessage(ofLogLevel level, uint16_t moduleId, const string & message, uint64_t time, const ofxSuperLogThread::Info & thread); //split in lines
+	void trimLines(); //compress & evict as the limits say
+	void pushLine(ofLogLevel level, uint16_t moduleId, const char * text, size_t len, uint64_t time, const ofxSuperLogThread::Info & thread);
+	void popOldestLine();
+	void popOldest(); //oldest line, or oldest compressed block
+	void forgetLineStats(ofLogLevel level, bool counted); //for the oldest line, when it goes away
+	size_t numLines(); //compressed + uncompressed
+	void getLine(size_t i, DrawLine & out); //0 is the oldest line
+	void sealOldestLines(); //moves the oldest LOG_COMPRESSED_BLOCK_LINES lines into a compressed block
+	void resetLines(); //clears everything, leaves the blank first line
+
+	struct CompressedBlock{
+		uint64_t id;
+		uint32_t rawSize;
+		vector<uint8_t> data;
+		vector<uint8_t> levels; //per line, LOG_LEVEL_UNCOUNTED set for blank lines
+		vector<uint16_t> moduleIds; //per line, to rebuild filter views without decompressing
+		size_t numBytes;
+	};
+	deque<CompressedBlock> compressedBlocks; //oldest first, all before lineRing
+	uint64_t nextBlockId = 0;
+	size_t maxUncompressedLines = 0; //0 = compression off
+	struct DecompressedBlock{
+		uint64_t id;
+		vector<LogLine> lines; //offsets are into text
+		vector<char> text;
 	};
+	list<DecompressedBlock> decompressedBlocks; //small LRU, most recent first
+	const DecompressedBlock & getDecompressedBlock(const CompressedBlock & b);
+
+	//per level line counts for a run of LOG_MINIMAP_BUCKET_LINES lines, kept up to date as lines come and go
+	//so the scrollbar minimap can show where warnings & errors are without looking at the lines
+	struct LevelBucket{
+		uint64_t index; //firstLineSeq / LOG_MINIMAP_BUCKET_LINES
+		uint32_t total = 0;
+		uint32_t counts[OF_LOG_SILENT + 1] = {0};
+	};
+	deque<LevelBucket> levelBuckets;
+	uint64_t firstLineSeq = 0; //sequence # of the oldest line
+	uint64_t nextLineSeq = 0;
+	static void addToBuckets(deque<LevelBucket> & buckets, uint64_t seq, ofLogLevel level, bool counted);
+	static void removeOldestFromBuckets(deque<LevelBucket> & buckets, ofLogLevel level, bool counted);
+
+	//the filtered view: the sequence #s of the lines that pass, with their own minimap buckets.
+	//View positions are numbered like line sequence #s, so drawing works the same on both.
+	struct FilterView{
+		bool active = false;
+		uint8_t levelMask = LOG_ALL_LEVELS;
+		deque<uint64_t> lineSeqs; //oldest first
+		deque<LevelBucket> buckets;
+		uint64_t firstSeq = 0; //view position of lineSeqs.front()
+		uint64_t nextSeq = 0;
+	};
+	FilterView filter;
+	vector<string> filterModules;
+	int filterModuleCycle = -1; //'m' key, index into the module names; -1 for all
+	bool passesFilter(ofLogLevel level, uint16_t moduleId, size_t length){
+		return length > 0 && (filter.levelMask & (1 << level)) && modules[moduleId].inFilter;
+	}
+	void addToFilter(uint64_t lineSeq, ofLogLevel level);
+	void rebuildFilter(); //with the mutex locked
+	size_t viewSize(){return filter.active ? filter.lineSeqs.size() : numLines();}
+	size_t viewLine(size_t i){return filter.active ? filter.lineSeqs[i] - firstLineSeq : i;} //view position to line index
+	void getFilteredLine(size_t pos, DrawLine & out); //getLine() for view position pos, cached if compressed
+	std::unordered_map<uint64_t, DrawLine> filterLineCache; //by line seq #, with the mutex locked
+	void drawMinimap(const deque<LevelBucket> & buckets, uint64_t firstSeq, size_t numLines, float x, float w, float pad, float h);
 
 	bool enabled;
 	bool autoDraw;
-	deque<LogLine> logLines;
 
 	float lastW; //manual drawing
 	float lastH;
 
-	const ofColor& getColorForModule(const string & modName);
+	ofColor getColorForModule(const string & modName);
 
 	int MAX_NUM_LOG_LINES;
+	size_t maxLogBytes = 0;
+	size_t logBytes = 0;
 	bool minimized;
 	
 	float widthPct; //how wide is the logging scrollist , pct of ofGetWidth()
@@ -131,7 +287,6 @@ protected:
 
 	bool useColors;
 	ofColor logColors[6]; //6 being the # of ofLogLevels. This is not very future proof - TODO!
-	std::unordered_map<string, ofColor> moduleColors;
 
 	#ifdef USE_OFX_FONTSTASH
 	ofxFontStash * font;
@@ -141,5 +296,20 @@ protected:
 	float charW = 8; //bitmapfont w
 	size_t maxModuleLen = 8; //len of the longest OF log module
 	
-	bool displayTimes = false;
+	TimeDisplayMode timeDisplayMode = TIME_HIDDEN;
+	bool displayThreads = false;
+	string getTimeString(const DrawLine & l, const DrawLine * prev); //time & thread columns, as configured
+	vector<DrawLine> linesCopy; //draw() only
+
+	//soft wrap, draw() only. Layouts are by line seq # and only exist for long lines that have been on screen
+	struct WrapLayout{
+		size_t prefix; //time & thread chars on the first row
+		vector<uint32_t> breaks; //where rows 2.. start in the line
+	};
+	bool wordWrap = false;
+	std::unordered_map<uint64_t, WrapLayout> wrapCache;
+	int wrapCacheCols = 0; //columns the cache was laid out for
+	int wrapExtraRows = 0; //rows added by wrapping at the top of the log, to let it scroll that much further
+	size_t getWrapRows(const DrawLine & l, size_t prefix, int cols, const vector<uint32_t> * & breaks);
+	static void wrapText(const string & text, size_t firstCols, size_t cols, vector<uint32_t> & breaks);
 };
@@ -0,0 +1,458 @@
+/**
+ *  ofxSuperLogFile.cpp
+ *
+ */
+
+#include "ofxSuperLogFile.h"
+#include <cstdarg>
+#include <stdio.h>
+
+#define SUPERLOG_INDEX_VERSION 1
+
+#ifdef TARGET_WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+	#include <fcntl.h>
+#endif
+
+ofxSuperLogFile::ofxSuperLogFile(){}
+
+ofxSuperLogFile::~ofxSuperLogFile(){
+	close();
+}
+
+bool ofxSuperLogFile::setFile(const string & path, bool append){
+	close();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		filePath = path;
+		if(useUring){
+			uring = unique_ptr<ofxSuperLogUring>(new ofxSuperLogUring());
+			if(uring->open(ofToDataPath(path, true), append, uringBufferBytes, uringNumBuffers)){
+				fileOffset = uring->getSize();
+			}else{
+				uring.reset(); //stdio it is
+			}
+		}
+		if(!uring){
+			file = openStdioLocked(append);
+			if(file){
+				fseek(file, 0, SEEK_END);
+				fileOffset = ftell(file);
+			}
+		}
+		if(isOpenLocked() && indexEnabled) openIndex();
+		linesSinceFlush = 0;
+		dirty = false;
+	}
+	if(useUring && !uring && file){
+		ofLogNotice("ofxSuperLogFile") << "io_uring is not available, writing the log file with stdio";
+	}
+	if(!isOpenLocked()){ //we are probably the current logger channel, so don't log while holding the lock
+		ofLogError("ofxSuperLogFile") << "can't open log file at \"" << path << "\"";
+		return false;
+	}
+	if(flushPolicy == FLUSH_TIMED) startTimer();
+	return true;
+}
+
+void ofxSuperLogFile::close(){
+	stopTimer();
+	std::lock_guard<std::mutex> lock(mutex);
+	if(uring){
+		closeIndex();
+		uring->close(); //waits for the writes in flight
+		uring.reset();
+	}
+	if(file){
+		closeIndex();
+		flushLocked(false);
+		fclose(file);
+		file = nullptr;
+	}
+}
+
+void ofxSuperLogFile::setIndexEnabled(bool enabled, uint32_t chunkBytes){
+	std::lock_guard<std::mutex> lock(mutex);
+	indexChunkBytes = std::max(chunkBytes, uint32_t(4096));
+	if(enabled == indexEnabled) return;
+	indexEnabled = enabled;
+	if(!isOpenLocked()) return;
+	if(enabled) openIndex();
+	else closeIndex();
+}
+
+void ofxSuperLogFile::openIndex(){
+	string path = ofToDataPath(filePath, true) + ".idx";
+	indexFile = fopen(path.c_str(), "ab");
+	if(!indexFile) return;
+	fseek(indexFile, 0, SEEK_END);
+	if(ftell(indexFile) == 0){
+		IndexHeader h = {{'S', 'L', 'I', 'X'}, SUPERLOG_INDEX_VERSION, indexChunkBytes, sizeof(IndexEntry)};
+		fwrite(&h, sizeof(h), 1, indexFile);
+	}
+	memset(&chunk, 0, sizeof(chunk));
+	chunk.offset = fileOffset;
+}
+
+void ofxSuperLogFile::closeIndex(){
+	if(!indexFile) return;
+	writeIndexEntry(); //the last, partial, chunk
+	fclose(indexFile);
+	indexFile = nullptr;
+}
+
+void ofxSuperLogFile::writeIndexEntry(){
+	if(chunk.numRecords == 0) return;
+	fwrite(&chunk, sizeof(chunk), 1, indexFile);
+	fflush(indexFile); //once per chunk, cheap enough
+	memset(&chunk, 0, sizeof(chunk));
+	chunk.offset = fileOffset;
+}
+
+bool ofxSuperLogFile::loadIndex(const string & indexPath, vector<IndexEntry> & entries){
+	entries.clear();
+	FILE * f = fopen(ofToDataPath(indexPath, true).c_str(), "rb");
+	if(!f) return false;
+	IndexHeader h;
+	bool ok = fread(&h, sizeof(h), 1, f) == 1 && memcmp(h.magic, "SLIX", 4) == 0 &&
+			  h.version == SUPERLOG_INDEX_VERSION && h.entrySize == sizeof(IndexEntry);
+	IndexEntry e;
+	while(ok && fread(&e, sizeof(e), 1, f) == 1){
+		entries.push_back(e);
+	}
+	fclose(f);
+	return ok;
+}
+
+size_t ofxSuperLogFile::findChunk(const vector<IndexEntry> & entries, int64_t wallTime){
+	auto it = std::lower_bound(entries.begin(), entries.end(), wallTime, [](const IndexEntry & e, int64_t t){
+		return e.lastTime < t;
+	});
+	return it - entries.begin();
+}
+
+bool ofxSuperLogFile::isOpen(){
+	std::lock_guard<std::mutex> lock(mutex);
+	return isOpenLocked();
+}
+
+void ofxSuperLogFile::setFlushPolicy(FlushPolicy p, int n){
+	stopTimer();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		flushPolicy = p;
+		flushN = std::max(n, 1);
+		linesSinceFlush = 0;
+		if(isOpenLocked()) flushLocked(false);
+	}
+	if(p == FLUSH_TIMED && isOpen()) startTimer();
+}
+
+void ofxSuperLogFile::setFlushLevel(ofLogLevel level, bool sync){
+	std::lock_guard<std::mutex> lock(mutex);
+	flushLevel = level;
+	syncOnFlushLevel = sync;
+}
+
+void ofxSuperLogFile::setFlightRecorder(bool enabled, ofLogLevel persistLevel, ofLogLevel triggerLevel, size_t contextLines,
+										float contextSeconds, size_t tailLines, size_t ringBytes){
+	std::lock_guard<std::mutex> lock(mutex);
+	recording = enabled;
+	recorderPersistLevel = persistLevel;
+	recorderTriggerLevel = triggerLevel;
+	recorderContextMicros = uint64_t(std::max(contextSeconds, 0.0f) * 1000000);
+	recorderTailLines = tailLines;
+	recorderTailLeft = 0;
+	recorderFirst = recorderCount = 0;
+	recorderTextHead = 0;
+	if(enabled){
+		recorderLines.assign(std::max(contextLines, size_t(1)), RecorderLine());
+		recorderText.assign(std::max(ringBytes, size_t(4096)), 0);
+	}else{
+		vector<RecorderLine>().swap(recorderLines);
+		vector<char>().swap(recorderText);
+	}
+}
+
+bool ofxSuperLogFile::setIoUringEnabled(bool enabled, size_t bufferBytes, int numBuffers){
+	if(enabled && !ofxSuperLogUring::isAvailable()){
+		ofLogNotice("ofxSuperLogFile") << "io_uring is not available here, writing the log file with stdio";
+		enabled = false;
+	}
+	useUring = enabled;
+	uringBufferBytes = bufferBytes;
+	uringNumBuffers = numBuffers;
+	if(isOpen()){
+		setFile(filePath, true);
+	}
+	return enabled;
+}
+
+void ofxSuperLogFile::setBufferSize(size_t bytes){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		bufferSize = bytes;
+		if(!file) return; //closed, or io_uring, which has its own buffers
+		//setvbuf only works on a fresh stream: reopen it, without letting go of the lock so no log() slips in between
+		flushLocked(false);
+		fclose(file);
+		file = openStdioLocked(true);
+		if(file) return;
+	}
+	ofLogError("ofxSuperLogFile") << "can't reopen log file at \"" << filePath << "\"";
+}
+
+void ofxSuperLogFile::flush(bool sync){
+	std::lock_guard<std::mutex> lock(mutex);
+	flushLocked(sync);
+}
+
+void ofxSuperLogFile::flushLocked(bool sync){
+	if(uring){
+		uring->flush(sync);
+		if(uring->hasFailed()) uringToStdioLocked();
+		linesSinceFlush = 0;
+		dirty = false;
+		return;
+	}
+	if(!file) return;
+	fflush(file);
+	if(sync){
+		#if defined(TARGET_WIN32)
+		_commit(_fileno(file));
+		#elif defined(TARGET_OSX)
+		fcntl(fileno(file), F_FULLFSYNC);
+		#else
+		fdatasync(fileno(file));
+		#endif
+	}
+	linesSinceFlush = 0;
+	dirty = false;
+}
+
+void ofxSuperLogFile::log(ofLogLevel level, const string & module, const string & message){
+	log(level, module, message, ofxSuperLogClock::now());
+}
+
+void ofxSuperLogFile::log(ofLogLevel level, const string & module, const string & message, uint64_t time){
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!isOpenLocked()) return;
+
+	//same layout as ofFileLoggerChannel
+	lineBuffer.clear();
+	lineBuffer += '[';
+	lineBuffer += ofGetLogLevelName(level, true);
+	lineBuffer += "] ";
+	if(module.size()){
+		lineBuffer += module;
+		lineBuffer += ": ";
+	}
+	lineBuffer += message;
+	lineBuffer += '\n';
+	if(putLine(level, lineBuffer.data(), lineBuffer.size(), time)){
+		flushAfterWrite(level >= flushLevel && level != OF_LOG_SILENT);
+	}
+}
+
+void ofxSuperLogFile::log(const ofxSuperLogFormat & format, const ofxSuperLogFormat::Fields & fields){
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!isOpenLocked()) return;
+
+	lineBuffer.clear();
+	format.append(lineBuffer, fields);
+	lineBuffer += '\n';
+	if(putLine(fields.level, lineBuffer.data(), lineBuffer.size(), fields.time)){
+		flushAfterWrite(fields.level >= flushLevel && fields.level != OF_LOG_SILENT);
+	}
+}
+
+void ofxSuperLogFile::log(const ofxSuperLogBatch & batch, const ofxSuperLogFormat & format, uint64_t time, const ofxSuperLogThread::Info & thread){
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!isOpenLocked() || batch.empty()) return;
+
+	bool urgent = false;
+	if(recording){ //line by line, most of them only go to the ring
+		bool written = false;
+		for(size_t i = 0; i < batch.size(); i++){
+			const ofxSuperLogBatch::Line & l = batch[i];
+			lineBuffer.clear();
+			format.append(lineBuffer, {l.level, &l.filteredModule, &l.message, time, &thread});
+			lineBuffer += '\n';
+			if(putLine(l.level, lineBuffer.data(), lineBuffer.size(), time)){
+				written = true;
+				urgent |= l.level >= flushLevel && l.level != OF_LOG_SILENT;
+			}
+		}
+		if(written) flushAfterWrite(urgent);
+		return;
+	}
+
+	lineBuffer.clear();
+	for(size_t i = 0; i < batch.size(); i++){
+		const ofxSuperLogBatch::Line & l = batch[i];
+		size_t start = lineBuffer.size();
+		format.append(lineBuffer, {l.level, &l.filteredModule, &l.message, time, &thread});
+		lineBuffer += '\n';
+		lineWritten(l.level, lineBuffer.size() - start, time);
+		urgent |= l.level >= flushLevel && l.level != OF_LOG_SILENT;
+	}
+	writeLocked(lineBuffer.data(), lineBuffer.size()); //one write for the lot
+	flushAfterWrite(urgent);
+}
+
+bool ofxSuperLogFile::putLine(ofLogLevel level, const char * data, size_t len, uint64_t time){
+	if(recording && level != OF_LOG_SILENT){
+		if(level >= recorderTriggerLevel){
+			writeRecorderContext(time);
+			recorderTailLeft = recorderTailLines;
+		}else if(recorderTailLeft > 0){
+			recorderTailLeft--;
+		}else if(level < recorderPersistLevel){
+			recordLine(level, data, len, time); //memory only
+			return false;
+		}
+	}
+	writeLocked(data, len);
+	lineWritten(level, len, time);
+	if(uring && uring->hasFailed()) uringToStdioLocked(); //between lines, so its notice doesn't land inside one
+	return true;
+}
+
+void ofxSuperLogFile::recordLine(ofLogLevel level, const char * data, size_t len, uint64_t time){
+	size_t textSize = recorderText.size();
+	if(len > textSize) return; //won't fit, ever
+	while(recorderCount && (recorderCount == recorderLines.size() || recorderTextHead + len - recorderLines[recorderFirst].start > textSize)){
+		recorderFirst = (recorderFirst + 1) % recorderLines.size(); //oldest out
+		recorderCount--;
+	}
+	RecorderLine & l = recorderLines[(recorderFirst + recorderCount) % recorderLines.size()];
+	l.time = time;
+	l.start = recorderTextHead;
+	l.len = len;
+	l.level = level;
+	recorderCount++;
+
+	size_t pos = recorderTextHead % textSize;
+	size_t first = std::min(len, textSize - pos);
+	memcpy(recorderText.data() + pos, data, first);
+	memcpy(recorderText.data(), data + first, len - first);
+	recorderTextHead += len;
+}
+
+void ofxSuperLogFile::writeRecorderContext(uint64_t triggerTime){
+	size_t textSize = recorderText.size();
+	for(size_t i = 0; i < recorderCount; i++){
+		const RecorderLine & l = recorderLines[(recorderFirst + i) % recorderLines.size()];
+		if(recorderContextMicros && l.time + recorderContextMicros < triggerTime) continue; //too old
+		size_t pos = l.start % textSize;
+		size_t first = std::min(size_t(l.len), textSize - pos);
+		writeLocked(recorderText.data() + pos, first);
+		if(first < l.len) writeLocked(recorderText.data(), l.len - first);
+		lineWritten(l.level, l.len, l.time);
+	}
+	recorderFirst = recorderCount = 0;
+}
+
+void ofxSuperLogFile::writeLocked(const char * data, size_t len){
+	if(uring) uring->write(data, len);
+	else fwrite(data, 1, len, file);
+	dirty = true;
+}
+
+void ofxSuperLogFile::pushLocked(){
+	if(!uring){
+		flushLocked(false);
+		return;
+	}
+	uring->submit(); //queued for the kernel, don't wait for it
+	if(uring->hasFailed()) uringToStdioLocked();
+	linesSinceFlush = 0;
+	dirty = false;
+}
+
+void ofxSuperLogFile::uringToStdioLocked(){
+	uring->close(); //what was queued is on disk once this returns
+	uring.reset();
+	file = openStdioLocked(true);
+	if(!file) return;
+	//we might be the logger's channel, ofLog from here would come back to our mutex: say it in the file
+	string line = "[" + ofGetLogLevelName(OF_LOG_WARNING, true) + "] ofxSuperLogFile: io_uring stopped taking writes, using stdio from here on\n";
+	fwrite(line.data(), 1, line.size(), file);
+	lineWritten(OF_LOG_WARNING, line.size(), ofxSuperLogClock::now());
+}
+
+FILE * ofxSuperLogFile::openStdioLocked(bool append){
+	FILE * f = fopen(ofToDataPath(filePath, true).c_str(), append ? "ab" : "wb");
+	if(f && bufferSize > 0){
+		buffer.resize(bufferSize);
+		setvbuf(f, buffer.data(), _IOFBF, buffer.size());
+	}
+	return f;
+}
+
+void ofxSuperLogFile::lineWritten(ofLogLevel level, size_t lineBytes, uint64_t time){
+	fileOffset += lineBytes;
+	if(indexFile){
+		int64_t wall = ofxSuperLogClock::toWallMicros(time);
+		//flight recorder context lines come in after records newer than them
+		chunk.firstTime = chunk.numRecords == 0 ? wall : std::min(chunk.firstTime, wall);
+		chunk.lastTime = chunk.numRecords == 0 ? wall : std::max(chunk.lastTime, wall);
+		chunk.numRecords++;
+		if(level <= OF_LOG_FATAL_ERROR) chunk.levelCounts[level]++;
+		chunk.size += lineBytes;
+		if(chunk.size >= indexChunkBytes) writeIndexEntry();
+	}
+	linesSinceFlush++;
+}
+
+void ofxSuperLogFile::flushAfterWrite(bool urgent){
+	if(urgent){
+		flushLocked(syncOnFlushLevel);
+		return;
+	}
+	switch(flushPolicy){
+		case FLUSH_EVERY_LINE: pushLocked(); break;
+		case FLUSH_EVERY_N_LINES: if(linesSinceFlush >= flushN) pushLocked(); break;
+		default: break; //FLUSH_TIMED is handled by the timer thread, FLUSH_ON_CLOSE by close()
+	}
+}
+
+void ofxSuperLogFile::log(ofLogLevel logLevel, const string & module, const char* format, ...){
+	va_list args;
+	va_start(args, format);
+	log(logLevel, module, format, args);
+	va_end(args);
+}
+
+void ofxSuperLogFile::log(ofLogLevel logLevel, const string & module, const char* format, va_list args){
+	log(logLevel, module, ofVAArgsToString(format, args));
+}
+
+void ofxSuperLogFile::startTimer(){
+	std::lock_guard<std::mutex> lock(timerMutex);
+	if(timerRunning) return;
+	timerRunning = true;
+	timerThread = std::thread(&ofxSuperLogFile::timerFunction, this);
+}
+
+void ofxSuperLogFile::stopTimer(){
+	{
+		std::lock_guard<std::mutex> lock(timerMutex);
+		if(!timerRunning) return;
+		timerRunning = false;
+	}
+	timerCondition.notify_all();
+	if(timerThread.joinable()) timerThread.join();
+}
+
+void ofxSuperLogFile::timerFunction(){
+	std::unique_lock<std::mutex> timerLock(timerMutex);
+	while(timerRunning){
+		timerCondition.wait_for(timerLock, std::chrono::milliseconds(flushN));
+		if(!timerRunning) break;
+		std::lock_guard<std::mutex> lock(mutex);
+		if(dirty) pushLocked();
+	}
+}
@@ -0,0 +1,179 @@
+/**
+ *  ofxSuperLogFile.h
+ *
+ *  Description:
+ *				File sink for ofxSuperLog. Same line layout as ofFileLoggerChannel, but with its
+ *				own write buffer and an explicit policy for when that buffer reaches the disk.
+ *
+ *  Usage:
+ *				ofxSuperLog::getLogger()->setFileFlushPolicy(ofxSuperLogFile::FLUSH_TIMED, 500);
+ *				ofxSuperLog::getLogger()->setFileFlushLevel(OF_LOG_ERROR, true); //errors hit the disk right away
+ *
+ *				Flight recorder mode keeps the chatty records in memory and only writes them out around errors:
+ *				ofxSuperLog::getLogger()->setFileFlightRecorder(true, OF_LOG_WARNING, OF_LOG_ERROR);
+ *
+ *				Optionally writes a sidecar seek index next to the log ("<log file>.idx"): one fixed size
+ *				IndexEntry per chunk of the log, so viewers & tools can binary search by time and skip
+ *				chunks without errors. See loadIndex() / findChunk().
+ */
+
+#pragma once
+#include "ofMain.h"
+#include "ofxSuperLogClock.h"
+#include "ofxSuperLogBatch.h"
+#include "ofxSuperLogFormat.h"
+#include "ofxSuperLogUring.h"
+
+class ofxSuperLogFile: public ofBaseLoggerChannel {
+public:
+
+	enum FlushPolicy{
+		FLUSH_EVERY_LINE,	//what ofFileLoggerChannel does (default)
+		FLUSH_EVERY_N_LINES,//flush once every N lines
+		FLUSH_TIMED,		//flush every N milliseconds, from a timer thread
+		FLUSH_ON_CLOSE		//never flush until close() (or the buffer fills up)
+	};
+
+	ofxSuperLogFile();
+	virtual ~ofxSuperLogFile();
+
+	bool setFile(const string & path, bool append = true);
+	void close();
+	bool isOpen();
+
+	///N is lines for FLUSH_EVERY_N_LINES, milliseconds for FLUSH_TIMED; ignored otherwise.
+	void setFlushPolicy(FlushPolicy p, int n = 0);
+	FlushPolicy getFlushPolicy(){return flushPolicy;}
+
+	///records at or above this level are flushed immediately regardless of the policy.
+	///if sync is true, they are also forced to the device (fdatasync) before log() returns.
+	///OF_LOG_SILENT disables it.
+	void setFlushLevel(ofLogLevel level, bool sync = false);
+
+	///size of the write buffer. 0 uses the C library default. If the file is already open,
+	///it is flushed and re-opened (appending) under the lock so the new buffer takes effect; records
+	///logged meanwhile from other threads wait for it rather than being dropped.
+	void setBufferSize(size_t bytes);
+
+	void flush(bool sync = false);
+
+	///flight recorder: records below persistLevel only go to an in-memory ring (the last contextLines lines,
+	///ringBytes at most). A record at or above triggerLevel first writes out the ring lines from the last
+	///contextSeconds (all of them if contextSeconds is 0), then the next tailLines records are written whatever
+	///their level. Context lines land
+	///after any persisted records that came in meanwhile, so the file isn't strictly in time order there.
+	void setFlightRecorder(bool enabled, ofLogLevel persistLevel = OF_LOG_WARNING, ofLogLevel triggerLevel = OF_LOG_ERROR,
+						   size_t contextLines = 5000, float contextSeconds = 30, size_t tailLines = 200, size_t ringBytes = 4 * 1024 * 1024);
+	bool isFlightRecorderEnabled(){std::lock_guard<std::mutex> lock(mutex); return recording;}
+
+	///Linux: write through io_uring instead of stdio, so log() never waits in write() for a busy disk.
+	///Lines are queued from numBuffers buffers of bufferBytes each; flush policies just queue them, flush()
+	///waits for them to land. Returns false (and keeps using stdio) if io_uring is not available.
+	///If the file is already open, it is re-opened (appending).
+	bool setIoUringEnabled(bool enabled, size_t bufferBytes = 256 * 1024, int numBuffers = 4);
+	bool isUsingIoUring(){std::lock_guard<std::mutex> lock(mutex); return uring != nullptr;}
+
+	//sidecar index ////////////////////////////////////////////////////////////
+
+	struct IndexEntry{ //on disk as is, after the IndexHeader
+		uint64_t offset; //byte offset of the chunk in the log file
+		uint64_t size; //bytes
+		int64_t firstTime; //wall clock, us since epoch
+		int64_t lastTime;
+		uint32_t numRecords;
+		uint32_t levelCounts[OF_LOG_FATAL_ERROR + 1];
+	};
+
+	struct IndexHeader{
+		char magic[4]; //"SLIX"
+		uint32_t version;
+		uint32_t chunkBytes;
+		uint32_t entrySize;
+	};
+
+	///starts a new index entry every chunkBytes of log. Applies to the open file right away.
+	void setIndexEnabled(bool enabled, uint32_t chunkBytes = 1024 * 1024);
+
+	static bool loadIndex(const string & indexPath, vector<IndexEntry> & entries);
+	///first chunk that may contain records at or after wallTime (us since epoch); entries.size() if none
+	static size_t findChunk(const vector<IndexEntry> & entries, int64_t wallTime);
+
+	void log(ofLogLevel level, const string & module, const string & message);
+	void log(ofLogLevel logLevel, const string & module, const char* format, ...);
+	void log(ofLogLevel logLevel, const string & module, const char* format, va_list args);
+	void log(ofLogLevel level, const string & module, const string & message, uint64_t time); //time from ofxSuperLogClock::now()
+	///one line laid out by format
+	void log(const ofxSuperLogFormat & format, const ofxSuperLogFormat::Fields & fields);
+	///the whole batch in a single write, every line laid out by format with the same time & thread
+	void log(const ofxSuperLogBatch & batch, const ofxSuperLogFormat & format, uint64_t time, const ofxSuperLogThread::Info & thread);
+
+protected:
+
+	void openIndex(); //these need the mutex locked
+	void closeIndex();
+	void writeIndexEntry();
+	void lineWritten(ofLogLevel level, size_t lineBytes, uint64_t time); //offsets, index & flush counters
+	void flushAfterWrite(bool urgent); //as the flush policy says, or right away if urgent
+	bool putLine(ofLogLevel level, const char * data, size_t len, uint64_t time); //to the file or the flight recorder, true if written
+	void writeLocked(const char * data, size_t len); //to stdio or io_uring
+	void uringToStdioLocked(); //io_uring broke, go on with stdio
+	FILE * openStdioLocked(bool append); //filePath, with our buffer
+	void pushLocked(); //hands buffered lines to the OS without waiting for the disk (flush policies)
+	bool isOpenLocked(){return file || uring;}
+	string lineBuffer; //formatted lines before they go to the file, reused
+
+	void flushLocked(bool sync); //call with mutex locked
+	void startTimer();
+	void stopTimer();
+	void timerFunction();
+
+	FILE * file = nullptr;
+	unique_ptr<ofxSuperLogUring> uring; //instead of file, when enabled & available
+	bool useUring = false;
+	size_t uringBufferBytes = 256 * 1024;
+	int uringNumBuffers = 4;
+	string filePath;
+	vector<char> buffer;
+	size_t bufferSize = 0;
+
+	FlushPolicy flushPolicy = FLUSH_EVERY_LINE;
+	int flushN = 0;
+	int linesSinceFlush = 0;
+	bool dirty = false;
+
+	ofLogLevel flushLevel = OF_LOG_SILENT;
+	bool syncOnFlushLevel = false;
+
+	bool indexEnabled = false;
+	uint32_t indexChunkBytes = 1024 * 1024;
+	FILE * indexFile = nullptr;
+	IndexEntry chunk;
+	uint64_t fileOffset = 0; //where the next line will land
+
+	struct RecorderLine{
+		uint64_t time;
+		uint64_t start; //in recorderText, counting from the first byte ever recorded
+		uint32_t len;
+		ofLogLevel level;
+	};
+	void recordLine(ofLogLevel level, const char * data, size_t len, uint64_t time);
+	void writeRecorderContext(uint64_t triggerTime);
+	bool recording = false;
+	ofLogLevel recorderPersistLevel = OF_LOG_WARNING;
+	ofLogLevel recorderTriggerLevel = OF_LOG_ERROR;
+	uint64_t recorderContextMicros = 0; //0: no time limit
+	size_t recorderTailLines = 0;
+	size_t recorderTailLeft = 0; //records still to write after a trigger
+	vector<RecorderLine> recorderLines; //ring
+	size_t recorderFirst = 0;
+	size_t recorderCount = 0;
+	vector<char> recorderText; //ring
+	uint64_t recorderTextHead = 0;
+
+	std::mutex mutex;
+
+	std::thread timerThread;
+	std::mutex timerMutex;
+	std::condition_variable timerCondition;
+	bool timerRunning = false;
+};
@@ -0,0 +1,133 @@
+/**
+ *  ofxSuperLogFormat.cpp
+ *
+ */
+
+#include "ofxSuperLogFormat.h"
+#include "ofxSuperLogClock.h"
+
+bool ofxSuperLogFormat::compile(const string & pattern_, bool colors_){
+
+	pattern = pattern_;
+	colors = colors_;
+	ops.clear();
+	literals.clear();
+
+	struct Token{
+		const char * text;
+		OpType type;
+	};
+	static const Token tokens[] = { //longest first where they share a prefix
+		{"ms", MILLIS}, {"us", MICROS}, {"T", DATE_TIME}, {"S", SINCE_START}, {"L", LEVEL}, {"M", MODULE},
+		{"m", MESSAGE}, {"t", THREAD}, {"c", COLOR}, {"r", COLOR_RESET}, {"e", EMOJI}
+	};
+
+	bool ok = true;
+	auto addLiteral = [&](const char * text, size_t len){
+		if(ops.size() && ops.back().type == LITERAL){
+			ops.back().length += len; //literals are contiguous, just extend the last one
+		}else{
+			ops.push_back({LITERAL, uint32_t(literals.size()), uint32_t(len)});
+		}
+		literals.append(text, len);
+	};
+
+	size_t i = 0;
+	while(i < pattern.size()){
+		if(pattern[i] != '%'){
+			addLiteral(&pattern[i], 1);
+			i++;
+			continue;
+		}
+		if(i + 1 < pattern.size() && pattern[i + 1] == '%'){
+			addLiteral("%", 1);
+			i += 2;
+			continue;
+		}
+		bool found = false;
+		for(auto & t : tokens){
+			size_t len = strlen(t.text);
+			if(pattern.compare(i + 1, len, t.text) == 0){
+				ops.push_back({t.type, 0, 0});
+				i += 1 + len;
+				found = true;
+				break;
+			}
+		}
+		if(!found){
+			ok = false;
+			addLiteral("%", 1);
+			i++;
+		}
+	}
+	if(!ok){
+		ofLogError("ofxSuperLog") << "unknown token in log format \"" << pattern << "\", kept as text";
+	}
+	return ok;
+}
+
+void ofxSuperLogFormat::appendNumber(string & out, uint64_t n, int minDigits){
+	char digits[24];
+	int len = 0;
+	do{
+		digits[len++] = '0' + n % 10;
+		n /= 10;
+	}while(n || len < minDigits);
+	while(len) out += digits[--len];
+}
+
+void ofxSuperLogFormat::append(string & out, const Fields & f) const{
+
+	//level names & colors, made once
+	static const string levelNames[] = {
+		ofGetLogLevelName(OF_LOG_VERBOSE, true), ofGetLogLevelName(OF_LOG_NOTICE, true), ofGetLogLevelName(OF_LOG_WARNING, true),
+		ofGetLogLevelName(OF_LOG_ERROR, true), ofGetLogLevelName(OF_LOG_FATAL_ERROR, true), ofGetLogLevelName(OF_LOG_SILENT, true)
+	};
+	static const char * levelColors[] = {
+		"\033[0;37m", //gray
+		"\033[0;32m", //green
+		"\033[30;43m", //yellow
+		"\033[30;41m", //red bg
+		"\033[30;45m", //purple
+		""
+	};
+	static const char * levelEmojis[] = {" ", " ", "⚠️ ", "‼️ ", "💣 ", " "};
+	size_t level = std::min(size_t(f.level), size_t(OF_LOG_SILENT));
+
+	//the wall clock is only looked up once per line, whatever the number of time tokens
+	const char * wallSecs = nullptr;
+	int wallMicros = 0;
+	auto wall = [&]{
+		if(!wallSecs) wallSecs = ofxSuperLogClock::formatWallSeconds(f.time, wallMicros);
+	};
+
+	for(const Op & op : ops){
+		switch(op.type){
+			case LITERAL: out.append(literals, op.offset, op.length); break;
+			case DATE_TIME: wall(); out += wallSecs; break;
+			case MILLIS: wall(); appendNumber(out, wallMicros / 1000, 3); break;
+			case MICROS: wall(); appendNumber(out, wallMicros, 6); break;
+			case SINCE_START:
+				appendNumber(out, f.time / 1000000);
+				out += '.';
+				appendNumber(out, f.time % 1000000, 6);
+				break;
+			case LEVEL: out += levelNames[level]; break;
+			case MODULE: if(f.module) out += *f.module; break;
+			case MESSAGE: if(f.message) out += *f.message; break;
+			case THREAD:
+				if(f.thread){
+					out += 'T';
+					appendNumber(out, f.thread->id);
+					if(f.thread->name){
+						out += ':';
+						out += *f.thread->name;
+					}
+				}
+				break;
+			case COLOR: if(colors) out += levelColors[level]; break;
+			case COLOR_RESET: if(colors) out += "\033[0;0m"; break;
+			case EMOJI: out += levelEmojis[level]; break;
+		}
+	}
+}
@@ -0,0 +1,83 @@
+/**
+ *  ofxSuperLogFormat.h
+ *
+ *  Description:
+ *				Line layout for the text sinks (log file, console, crash dumps). A pattern like
+ *				"%T.%ms [%L] %M: %m" is compiled once into a list of ops; append() runs them straight
+ *				into the caller's buffer, so formatting a line doesn't create any temporary strings.
+ *
+ *				%T	wall clock date & time, "2024/05/01 13:45:12"
+ *				%ms	milliseconds of %T, "042"
+ *				%us	microseconds of %T, "042117"
+ *				%S	seconds since app start, "12.345678"
+ *				%L	level, padded like ofGetLogLevelName(level, true)
+ *				%M	module, padded to the widest module logged so far
+ *				%m	message
+ *				%t	thread tag, "T3" or "T3:videoDecoder"
+ *				%c	start of the level color (colored terminals only)
+ *				%r	end of the level color
+ *				%e	level emoji and a space, for consoles without colors (Xcode)
+ *				%%	a '%'
+ *
+ *				Tokens are matched longest first: "%ms" is milliseconds, not a message followed by 's'.
+ *
+ *  Usage:
+ *				ofxSuperLog::getLogger()->setFileLogFormat("%T.%ms [%L] %M: %m");
+ */
+
+#pragma once
+#include "ofMain.h"
+#include "ofxSuperLogThread.h"
+
+class ofxSuperLogFormat {
+public:
+
+	struct Fields{
+		ofLogLevel level;
+		const string * module; //padded
+		const string * message;
+		uint64_t time; //ofxSuperLogClock::now()
+		const ofxSuperLogThread::Info * thread;
+	};
+
+	ofxSuperLogFormat(){}
+	ofxSuperLogFormat(const string & pattern, bool colors = false){compile(pattern, colors);}
+
+	///false if the pattern has unknown tokens; those are kept as literal text
+	bool compile(const string & pattern, bool colors = false);
+	const string & getPattern() const {return pattern;}
+	bool hasColors() const {return colors;}
+
+	///appends one line (without the newline) to out
+	void append(string & out, const Fields & f) const;
+
+protected:
+
+	enum OpType{
+		LITERAL,
+		DATE_TIME,
+		MILLIS,
+		MICROS,
+		SINCE_START,
+		LEVEL,
+		MODULE,
+		MESSAGE,
+		THREAD,
+		COLOR,
+		COLOR_RESET,
+		EMOJI
+	};
+
+	struct Op{
+		OpType type;
+		uint32_t offset; //LITERAL: text in literals
+		uint32_t length;
+	};
+
+	static void appendNumber(string & out, uint64_t n, int minDigits = 1);
+
+	vector<Op> ops;
+	string literals;
+	string pattern;
+	bool colors = false;
+};
@@ -0,0 +1,102 @@
+/**
+ *  ofxSuperLogHistory.cpp
+ *
+ */
+
+#include "ofxSuperLogHistory.h"
+
+void ofxSuperLogHistory::setMaxRecords(size_t n){
+	std::lock_guard<std::mutex> lock(mutex);
+	maxRecords = n;
+	size_t maxSegments = n ? n / SUPERLOG_HISTORY_SEGMENT_RECORDS + 2 : 0;
+	while(segments.size() > maxSegments) segments.pop_front();
+}
+
+void ofxSuperLogHistory::push(ofLogLevel level, const string & module, const string & message, uint64_t time){
+	std::lock_guard<std::mutex> lock(mutex);
+	if(maxRecords == 0) return;
+	append(level, module, message, time);
+}
+
+void ofxSuperLogHistory::push(const ofxSuperLogBatch & batch, uint64_t time){
+	std::lock_guard<std::mutex> lock(mutex);
+	if(maxRecords == 0) return;
+	for(size_t i = 0; i < batch.size(); i++){
+		append(batch[i].level, batch[i].module, batch[i].message, time);
+	}
+}
+
+void ofxSuperLogHistory::append(ofLogLevel level, const string & module, const string & message, uint64_t time){
+	if(segments.empty() || segments.back()->count.load(std::memory_order_relaxed) == SUPERLOG_HISTORY_SEGMENT_RECORDS){
+		size_t maxSegments = maxRecords.load(std::memory_order_relaxed) / SUPERLOG_HISTORY_SEGMENT_RECORDS + 2; //so at least maxRecords are always kept
+		if(segments.size() >= maxSegments) segments.pop_front(); //snapshots may still hold it
+		segments.push_back(make_shared<Segment>());
+	}
+	Segment & s = *segments.back();
+	uint32_t n = s.count.load(std::memory_order_relaxed);
+	Record & r = s.records[n];
+	lastTime = std::max(lastTime, time);
+	r.time = lastTime;
+	r.level = level;
+	r.module = module;
+	r.message = message;
+	r.thread = ofxSuperLogThread::current();
+	s.count.store(n + 1, std::memory_order_release);
+}
+
+ofxSuperLogHistory::Snapshot ofxSuperLogHistory::getSnapshot(){
+	Snapshot snap;
+	std::lock_guard<std::mutex> lock(mutex);
+	snap.segments.assign(segments.begin(), segments.end());
+	if(segments.size()){
+		snap.count = (segments.size() - 1) * SUPERLOG_HISTORY_SEGMENT_RECORDS + segments.back()->count.load(std::memory_order_acquire);
+	}
+	return snap;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+ofxSuperLogHistory::Snapshot ofxSuperLogHistory::Snapshot::range(size_t from, size_t to) const{
+	Snapshot s;
+	to = std::min(to, count);
+	from = std::min(from, to);
+	size_t firstSeg = (first + from) / SUPERLOG_HISTORY_SEGMENT_RECORDS;
+	size_t lastSeg = (first + to + SUPERLOG_HISTORY_SEGMENT_RECORDS - 1) / SUPERLOG_HISTORY_SEGMENT_RECORDS;
+	if(from < to) s.segments.assign(segments.begin() + firstSeg, segments.begin() + lastSeg);
+	s.first = (first + from) % SUPERLOG_HISTORY_SEGMENT_RECORDS;
+	s.count = to - from;
+	return s;
+}
+
+ofxSuperLogHistory::Snapshot ofxSuperLogHistory::Snapshot::last(size_t n) const{
+	return range(count - std::min(n, count), count);
+}
+
+size_t ofxSuperLogHistory::Snapshot::lowerBound(uint64_t time) const{
+	size_t lo = 0, hi = count;
+	while(lo < hi){
+		size_t mid = lo + (hi - lo) / 2;
+		if((*this)[mid].time < time) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+ofxSuperLogHistory::Snapshot ofxSuperLogHistory::Snapshot::since(uint64_t time) const{
+	return range(lowerBound(time), count);
+}
+
+ofxSuperLogHistory::Snapshot ofxSuperLogHistory::Snapshot::between(uint64_t from, uint64_t to) const{
+	return range(lowerBound(from), lowerBound(to));
+}
+
+vector<const ofxSuperLogHistory::Record*> ofxSuperLogHistory::Snapshot::filter(ofLogLevel minLevel, const vector<string> & modules) const{
+	vector<const Record*> found;
+	for(size_t i = 0; i < count; i++){
+		const Record & r = (*this)[i];
+		if(r.level < minLevel) continue;
+		if(modules.size() && std::find(modules.begin(), modules.end(), r.module) == modules.end()) continue;
+		found.push_back(&r);
+	}
+	return found;
+}
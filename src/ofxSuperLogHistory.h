@@ -0,0 +1,98 @@
+/**
+ *  ofxSuperLogHistory.h
+ *
+ *  Description:
+ *				Keeps the most recent log records in memory so the app can query them (status pages,
+ *				"recent logs" in crash reports...) without re-reading the log file.
+ *
+ *				Records are appended to fixed size segments; full segments never change again. A
+ *				Snapshot just holds on to the segments it covers, so taking one only copies a few
+ *				pointers, and reading it never holds up log() callers. Evicted segments stay alive for
+ *				as long as a snapshot uses them.
+ *
+ *				Record times never go backwards (a record logged a few us "late" by a racing thread gets
+ *				its predecessor's time), so time lookups are binary searches.
+ *
+ *  Usage:
+ *				ofxSuperLog::getLogger()->setHistorySize(10000);
+ *				auto h = ofxSuperLog::getLogger()->getHistory().last(100);
+ *				for(size_t i = 0; i < h.size(); i++) cout << h[i].message << endl;
+ *
+ *				auto errors = ofxSuperLog::getLogger()->getHistory().since(ofxSuperLogClock::now() - 60 * 1000000).filter(OF_LOG_ERROR);
+ */
+
+#pragma once
+#include "ofMain.h"
+#include "ofxSuperLogThread.h"
+#include "ofxSuperLogBatch.h"
+
+#define SUPERLOG_HISTORY_SEGMENT_RECORDS 256
+
+class ofxSuperLogHistory {
+public:
+
+	struct Record{
+		uint64_t time; //ofxSuperLogClock::now()
+		ofLogLevel level;
+		string module;
+		string message;
+		ofxSuperLogThread::Info thread;
+	};
+
+protected:
+
+	struct Segment{
+		Record records[SUPERLOG_HISTORY_SEGMENT_RECORDS];
+		std::atomic<uint32_t> count{0}; //written records, only ever grows
+	};
+
+public:
+
+	///an immutable view of a range of records, oldest first. Cheap to copy.
+	class Snapshot{
+	public:
+		size_t size() const {return count;}
+		bool empty() const {return count == 0;}
+		const Record & operator[](size_t i) const {
+			size_t n = first + i;
+			return segments[n / SUPERLOG_HISTORY_SEGMENT_RECORDS]->records[n % SUPERLOG_HISTORY_SEGMENT_RECORDS];
+		}
+		const Record & front() const {return (*this)[0];}
+		const Record & back() const {return (*this)[count - 1];}
+
+		Snapshot last(size_t n) const;
+		Snapshot since(uint64_t time) const; //records at or after time (ofxSuperLogClock::now() units)
+		Snapshot between(uint64_t from, uint64_t to) const; //[from, to)
+		size_t lowerBound(uint64_t time) const; //index of the first record at or after time
+
+		///records at or above minLevel, and from one of modules (all if empty)
+		vector<const Record*> filter(ofLogLevel minLevel, const vector<string> & modules = vector<string>()) const;
+
+	protected:
+		friend class ofxSuperLogHistory;
+		Snapshot range(size_t from, size_t to) const;
+		vector<shared_ptr<const Segment>> segments;
+		size_t first = 0; //into segments[0]
+		size_t count = 0;
+	};
+
+	///0 disables it. At least n records are kept, up to two segments more.
+	void setMaxRecords(size_t n);
+	size_t getMaxRecords(){return maxRecords.load(std::memory_order_relaxed);}
+	bool isEnabled(){return maxRecords.load(std::memory_order_relaxed) > 0;} //log() checks it on every record, no lock
+
+	///called from log(), any thread
+	void push(ofLogLevel level, const string & module, const string & message, uint64_t time);
+	void push(const ofxSuperLogBatch & batch, uint64_t time); //one lock for the whole batch
+
+	Snapshot getSnapshot();
+
+protected:
+
+	void append(ofLogLevel level, const string & module, const string & message, uint64_t time); //call with mutex locked
+
+	std::mutex mutex; //between writers, and for the snapshot pointer copy
+	deque<shared_ptr<Segment>> segments; //oldest first
+	std::atomic<size_t> maxRecords{0}; //changed with the mutex locked
+	uint64_t lastTime = 0;
+};
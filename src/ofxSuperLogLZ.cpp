@@ -0,0 +1,105 @@
+/**
+ *  ofxSuperLogLZ.cpp
+ *
+ */
+
+#include "ofxSuperLogLZ.h"
+
+#define LZ_MIN_MATCH	4
+#define LZ_HASH_BITS	12
+#define LZ_MAX_OFFSET	65535
+
+static inline uint32_t read32(const uint8_t * p){
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t hash4(uint32_t v){
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static inline void writeLength(vector<uint8_t> & dst, size_t len){ //the part that didn't fit in the token nibble
+	while(len >= 255){
+		dst.push_back(255);
+		len -= 255;
+	}
+	dst.push_back(uint8_t(len));
+}
+
+static void writeSequence(vector<uint8_t> & dst, const uint8_t * lit, size_t litLen, size_t offset, size_t matchLen){
+	size_t m = matchLen ? matchLen - LZ_MIN_MATCH : 0;
+	uint8_t token = uint8_t((std::min(litLen, size_t(15)) << 4) | std::min(m, size_t(15)));
+	dst.push_back(token);
+	if(litLen >= 15) writeLength(dst, litLen - 15);
+	dst.insert(dst.end(), lit, lit + litLen);
+	if(matchLen){
+		dst.push_back(uint8_t(offset & 0xff));
+		dst.push_back(uint8_t(offset >> 8));
+		if(m >= 15) writeLength(dst, m - 15);
+	}
+}
+
+void ofxSuperLogLZ::compress(const uint8_t * src, size_t srcSize, vector<uint8_t> & dst){
+	dst.clear();
+	dst.reserve(srcSize / 2 + 16);
+	uint32_t table[1 << LZ_HASH_BITS];
+	for(auto & t : table) t = UINT32_MAX;
+
+	size_t anchor = 0; //start of pending literals
+	size_t i = 0;
+	while(srcSize >= LZ_MIN_MATCH && i <= srcSize - LZ_MIN_MATCH){
+		uint32_t v = read32(src + i);
+		uint32_t h = hash4(v);
+		uint32_t cand = table[h];
+		table[h] = uint32_t(i);
+		if(cand != UINT32_MAX && i - cand <= LZ_MAX_OFFSET && read32(src + cand) == v){
+			size_t len = LZ_MIN_MATCH;
+			while(i + len < srcSize && src[cand + len] == src[i + len]) len++;
+			writeSequence(dst, src + anchor, i - anchor, i - cand, len);
+			i += len;
+			anchor = i;
+		}else{
+			i++;
+		}
+	}
+	writeSequence(dst, src + anchor, srcSize - anchor, 0, 0);
+}
+
+static inline bool readLength(const uint8_t *& p, const uint8_t * end, size_t & len){
+	uint8_t b;
+	do{
+		if(p >= end) return false;
+		b = *p++;
+		len += b;
+	}while(b == 255);
+	return true;
+}
+
+bool ofxSuperLogLZ::decompress(const uint8_t * src, size_t srcSize, uint8_t * dst, size_t dstSize){
+	const uint8_t * p = src;
+	const uint8_t * end = src + srcSize;
+	size_t out = 0;
+	while(p < end){
+		uint8_t token = *p++;
+		size_t litLen = token >> 4;
+		if(litLen == 15 && !readLength(p, end, litLen)) return false;
+		if(size_t(end - p) < litLen || dstSize - out < litLen) return false;
+		if(litLen) memcpy(dst + out, p, litLen);
+		p += litLen;
+		out += litLen;
+		if(p == end) break; //last sequence, literals only
+
+		if(end - p < 2) return false;
+		size_t offset = p[0] | (size_t(p[1]) << 8);
+		p += 2;
+		size_t matchLen = token & 15;
+		if(matchLen == 15 && !readLength(p, end, matchLen)) return false;
+		matchLen += LZ_MIN_MATCH;
+		if(offset == 0 || offset > out || dstSize - out < matchLen) return false;
+		const uint8_t * from = dst + out - offset;
+		for(size_t k = 0; k < matchLen; k++) dst[out + k] = from[k]; //may overlap, byte by byte
+		out += matchLen;
+	}
+	return out == dstSize;
+}
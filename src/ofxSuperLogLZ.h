@@ -0,0 +1,24 @@
+/**
+ *  ofxSuperLogLZ.h
+ *
+ *  Description:
+ *				Tiny LZ77 codec (LZ4-like byte oriented format) used to keep old scrollback compressed
+ *				in memory. Favours speed over ratio; log text still compresses several times over
+ *				since modules, timestamps and message templates repeat a lot.
+ *
+ *				Stream of sequences: token byte (high nibble literal count, low nibble match length - 4,
+ *				15 meaning "more length bytes follow", each 255 adds and continues), literals,
+ *				2 byte little endian match offset. The last sequence only has literals.
+ */
+
+#pragma once
+#include "ofMain.h"
+
+class ofxSuperLogLZ {
+public:
+
+	static void compress(const uint8_t * src, size_t srcSize, vector<uint8_t> & dst);
+
+	///dstSize must be the exact uncompressed size. Returns false on corrupt input.
+	static bool decompress(const uint8_t * src, size_t srcSize, uint8_t * dst, size_t dstSize);
+};
@@ -0,0 +1,166 @@
+/**
+ *  ofxSuperLogOrdered.cpp
+ *
+ */
+
+#include "ofxSuperLogOrdered.h"
+
+static std::atomic<uint64_t> nextInstanceId{1};
+
+static bool laterSeq(const ofxSuperLogOrdered::Record & a, const ofxSuperLogOrdered::Record & b){
+	return a.seq > b.seq;
+}
+
+ofxSuperLogOrdered::ofxSuperLogOrdered(){
+	instanceId = nextInstanceId++;
+}
+
+ofxSuperLogOrdered::~ofxSuperLogOrdered(){
+	stop();
+}
+
+void ofxSuperLogOrdered::start(Callback cb){
+	stop();
+	callback = cb;
+	running = true;
+	thread = std::thread(&ofxSuperLogOrdered::threadedFunction, this);
+}
+
+void ofxSuperLogOrdered::stop(){
+	if(!running) return;
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		running = false;
+		//once we had each buffer, nobody is half way through a push() that saw us running
+		for(auto & b : buffers){
+			std::lock_guard<std::mutex> bufferLock(b->mutex);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex); //the consumer is either before its check of running, or waiting
+		wakeCondition.notify_all();
+	}
+	if(thread.joinable()) thread.join();
+}
+
+static thread_local bool threadExiting = false; //trivial, so still readable after ThreadBuffers is gone
+
+ofxSuperLogOrdered::Buffer * ofxSuperLogOrdered::getBuffer(){
+
+	struct ThreadBuffers{
+		vector<pair<uint64_t, shared_ptr<Buffer>>> buffers; //by logger instance
+		~ThreadBuffers(){
+			for(auto & b : buffers) b.second->threadAlive = false;
+			threadExiting = true;
+		}
+	};
+	if(threadExiting) return nullptr; //logging from a static destructor, or another thread_local's
+	static thread_local ThreadBuffers threadBuffers;
+
+	for(auto & b : threadBuffers.buffers){
+		if(b.first == instanceId) return b.second.get();
+	}
+	auto b = make_shared<Buffer>();
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		buffers.push_back(b);
+	}
+	threadBuffers.buffers.emplace_back(instanceId, b);
+	return b.get();
+}
+
+bool ofxSuperLogOrdered::push(Record && r){
+	Buffer * buffer = getBuffer();
+	if(!buffer) return false;
+	Buffer & b = *buffer;
+	std::unique_lock<std::mutex> lock(b.mutex);
+	if(!running) return false;
+	if(b.records.size() >= maxPendingPerThread){
+		numDropped++;
+		return true; //no seq taken, so the consumer doesn't wait for it
+	}
+	//seq is taken and published under the same lock, so the consumer never waits on a seq that isn't on its way
+	r.seq = nextSeq.fetch_add(1, std::memory_order_relaxed);
+	bool first = b.records.empty();
+	b.records.push_back(std::move(r));
+	lock.unlock();
+
+	//set under wakeMutex so it can't land between the consumer's check and its wait.
+	//If it's already set, the consumer hasn't cleared it yet and collects after it does.
+	if(first && !wakePending.load()){
+		std::lock_guard<std::mutex> wakeLock(wakeMutex);
+		if(!wakePending){
+			wakePending = true;
+			wakeCondition.notify_one();
+		}
+	}
+	return true;
+}
+
+void ofxSuperLogOrdered::flush(){
+	if(std::this_thread::get_id() == thread.get_id()) return; //from a sink, would never return
+	uint64_t target = nextSeq.load();
+	std::unique_lock<std::mutex> lock(wakeMutex);
+	wakePending = true;
+	wakeCondition.notify_one();
+	flushCondition.wait(lock, [&]{ return numOut.load() >= target || !running; });
+}
+
+void ofxSuperLogOrdered::collect(){
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	for(size_t i = 0; i < buffers.size(); i++){
+		Buffer & b = *buffers[i];
+		{
+			std::lock_guard<std::mutex> bufferLock(b.mutex);
+			collecting.swap(b.records);
+		}
+		for(auto & r : collecting){
+			heap.push_back(std::move(r));
+			std::push_heap(heap.begin(), heap.end(), laterSeq);
+		}
+		collecting.clear();
+		if(!b.threadAlive){ //its thread is gone and we just emptied it
+			bool empty;
+			{
+				std::lock_guard<std::mutex> bufferLock(b.mutex);
+				empty = b.records.empty();
+			}
+			if(empty){
+				buffers.erase(buffers.begin() + i);
+				i--;
+			}
+		}
+	}
+}
+
+void ofxSuperLogOrdered::threadedFunction(){
+
+	ofxSuperLogThread::setName("ofxSuperLogOrdered");
+
+	while(true){
+		{
+			std::unique_lock<std::mutex> lock(wakeMutex);
+			wakeCondition.wait(lock, [this]{
+				return wakePending.load() || !running;
+			});
+		}
+		wakePending = false;
+		bool stopping = !running;
+
+		collect();
+		//a missing seq is still being pushed by its thread, it will show up in the next round
+		while(heap.size() && heap.front().seq == nextOut){
+			std::pop_heap(heap.begin(), heap.end(), laterSeq);
+			callback(heap.back());
+			heap.pop_back();
+			nextOut++;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			numOut = nextOut;
+		}
+		flushCondition.notify_all();
+		if(stopping && nextOut == nextSeq.load()) break;
+	}
+}
@@ -0,0 +1,85 @@
+/**
+ *  ofxSuperLogOrdered.h
+ *
+ *  Description:
+ *				Whole-line, globally ordered logging without serializing the threads that log.
+ *				Each producer thread appends complete records to its own buffer, tagged with a
+ *				sequence number from a single atomic counter. One consumer thread collects all
+ *				buffers and hands records to the sinks strictly in sequence order, so lines never
+ *				interleave and the file reads in the order log() was called.
+ *
+ *				Producers only ever contend with the consumer on their own buffer, for the time it
+ *				takes to swap a vector; the atomic increment is the only thing all threads share.
+ *
+ *  Usage:
+ *				ofxSuperLog::getLogger()->setOrderedLogging(true);
+ */
+
+#pragma once
+#include "ofMain.h"
+#include "ofxSuperLogThread.h"
+
+class ofxSuperLogOrdered {
+public:
+
+	struct Record{
+		uint64_t seq;
+		ofLogLevel level;
+		uint64_t time; //ofxSuperLogClock::now()
+		ofxSuperLogThread::Info thread;
+		string module;
+		string filteredModule;
+		string message;
+	};
+
+	typedef std::function<void(const Record &)> Callback; //always called from the consumer thread
+
+	ofxSuperLogOrdered();
+	~ofxSuperLogOrdered();
+
+	void start(Callback cb);
+	void stop(); //hands out everything logged so far before returning
+	bool isRunning(){return running;}
+
+	///called from log(), any thread. Fills in seq. Returns false if not running (or the calling thread is
+	///exiting), the caller writes the record itself.
+	bool push(Record && r);
+
+	///blocks until everything pushed so far reached the callback
+	void flush();
+
+	size_t maxPendingPerThread = 100000; //records; beyond this, they are dropped
+	uint64_t getNumDropped(){return numDropped;}
+
+protected:
+
+	struct Buffer{
+		std::mutex mutex; //producer vs consumer only
+		vector<Record> records;
+		std::atomic<bool> threadAlive{true};
+	};
+
+	Buffer * getBuffer(); //the calling thread's, nullptr while the thread is exiting
+	void collect(); //consumer side, moves all buffered records into the heap
+	void threadedFunction();
+
+	uint64_t instanceId;
+	std::atomic<uint64_t> nextSeq{0};
+	uint64_t nextOut = 0; //consumer only
+	std::atomic<uint64_t> numOut{0};
+
+	vector<shared_ptr<Buffer>> buffers;
+	std::mutex buffersMutex;
+
+	vector<Record> collecting; //consumer only
+	vector<Record> heap; //consumer only, min heap by seq
+
+	Callback callback;
+	std::thread thread;
+	std::atomic<bool> running{false};
+	std::atomic<bool> wakePending{false};
+	std::mutex wakeMutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable flushCondition;
+	std::atomic<uint64_t> numDropped{0};
+};
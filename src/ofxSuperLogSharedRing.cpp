@@ -0,0 +1,362 @@
+/**
+ *  ofxSuperLogSharedRing.cpp
+ *
+ */
+
+#include "ofxSuperLogSharedRing.h"
+
+#ifndef TARGET_WIN32
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+
+#define SUPERLOG_RING_MAGIC		0x534c5247 //"SLRG"
+#define SUPERLOG_RING_VERSION	2
+#define SUPERLOG_RING_WRAP		1 //record flag, rest of the buffer is padding
+
+//lives at the start of the shared segment, data follows
+struct ofxSuperLogSharedRing::Header{
+	std::atomic<uint32_t> magic;
+	uint32_t version;
+	uint64_t capacity; //bytes of record data, multiple of 8
+	std::atomic<uint64_t> writePos; //ever-increasing byte counters, wrap with % capacity
+	std::atomic<uint64_t> readPos;
+	std::atomic<uint64_t> dropped;
+	std::atomic<int32_t> writerPid; //0 once the writer closed it
+	char sourceLabel[64];
+};
+
+struct RecordHeader{
+	uint32_t size; //whole record, including this header and padding
+	uint32_t flags;
+	uint64_t timestamp;
+	uint32_t messageLen;
+	uint16_t moduleLen;
+	uint8_t level;
+	uint8_t pad;
+};
+
+static inline size_t align8(size_t s){ return (s + 7) & ~size_t(7); }
+
+//a record as read from the ring, copied out so the writer can't change it after it was checked
+struct ofxSuperLogSharedRing::RecordView{
+	RecordHeader header;
+	const char * payload;
+};
+
+ofxSuperLogSharedRing::ofxSuperLogSharedRing(){}
+
+ofxSuperLogSharedRing::~ofxSuperLogSharedRing(){
+	close();
+}
+
+uint64_t ofxSuperLogSharedRing::nowMicros(){
+	using namespace std::chrono;
+	return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+bool ofxSuperLogSharedRing::map(int fd, size_t totalSize){
+	void * ptr = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(ptr == MAP_FAILED) return false;
+	header = (Header*)ptr;
+	data = (char*)ptr + align8(sizeof(Header));
+	mappedSize = totalSize;
+	return true;
+}
+
+bool ofxSuperLogSharedRing::create(const string & name_, const string & sourceLabel, size_t capacityBytes, mode_t mode){
+	close();
+	capacityBytes = align8(std::max(capacityBytes, size_t(4096)));
+	size_t totalSize = align8(sizeof(Header)) + capacityBytes;
+	int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT, mode);
+	if(fd < 0) return false;
+	struct stat st;
+	bool reuse = fstat(fd, &st) == 0 && size_t(st.st_size) == totalSize;
+	if(!reuse && ftruncate(fd, totalSize) != 0){
+		::close(fd);
+		return false;
+	}
+	if(!map(fd, totalSize)) return false;
+	name = name_;
+	owner = true;
+	capacity = capacityBytes;
+
+	//re-use a segment left over by a previous run of this app (the collector may still be attached to it)
+	if(!(reuse && header->magic.load() == SUPERLOG_RING_MAGIC && header->version == SUPERLOG_RING_VERSION &&
+		 header->capacity == capacityBytes)){
+		header->magic = 0;
+		header->version = SUPERLOG_RING_VERSION;
+		header->capacity = capacityBytes;
+		header->writePos = 0;
+		header->readPos = 0;
+		header->dropped = 0;
+		header->magic.store(SUPERLOG_RING_MAGIC, std::memory_order_release);
+	}
+	strncpy(header->sourceLabel, sourceLabel.c_str(), sizeof(header->sourceLabel) - 1);
+	header->sourceLabel[sizeof(header->sourceLabel) - 1] = 0;
+	header->writerPid.store(getpid(), std::memory_order_release);
+	return true;
+}
+
+bool ofxSuperLogSharedRing::attach(const string & name_){
+	close();
+	int fd = shm_open(name_.c_str(), O_RDWR, 0);
+	if(fd < 0) return false;
+	struct stat st;
+	if(fstat(fd, &st) != 0 || size_t(st.st_size) < align8(sizeof(Header)) + 4096){
+		::close(fd);
+		return false;
+	}
+	if(!map(fd, st.st_size)) return false;
+	if(header->magic.load(std::memory_order_acquire) != SUPERLOG_RING_MAGIC ||
+	   header->version != SUPERLOG_RING_VERSION ||
+	   align8(sizeof(Header)) + header->capacity != mappedSize){
+		close(); //not (yet) initialized by its writer
+		return false;
+	}
+	name = name_;
+	owner = false;
+	capacity = header->capacity;
+	numCorrupt = 0;
+	return true;
+}
+
+void ofxSuperLogSharedRing::close(){
+	if(header){
+		if(owner){
+			header->writerPid.store(0, std::memory_order_release);
+			//drained: nobody needs it anymore. Else the collector unlinks it once it has read the rest
+			if(header->readPos.load(std::memory_order_acquire) == header->writePos.load(std::memory_order_relaxed)){
+				shm_unlink(name.c_str());
+			}
+		}
+		munmap(header, mappedSize);
+	}
+	header = nullptr;
+	data = nullptr;
+	mappedSize = 0;
+}
+
+bool ofxSuperLogSharedRing::isWriterGone(){
+	if(!header) return true;
+	int32_t pid = header->writerPid.load(std::memory_order_acquire);
+	return pid <= 0 || (kill(pid, 0) != 0 && errno == ESRCH);
+}
+
+void ofxSuperLogSharedRing::unlink(){
+	if(header) shm_unlink(name.c_str());
+}
+
+string ofxSuperLogSharedRing::getSourceLabel(){
+	if(!header) return "";
+	return string(header->sourceLabel, strnlen(header->sourceLabel, sizeof(header->sourceLabel)));
+}
+
+uint64_t ofxSuperLogSharedRing::getNumDropped(){
+	return header ? header->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+bool ofxSuperLogSharedRing::write(ofLogLevel level, const string & module, const string & message){
+	if(!header) return false;
+	const uint64_t cap = capacity;
+	size_t moduleLen = std::min(module.size(), size_t(UINT16_MAX));
+	size_t messageLen = std::min(message.size(), size_t(cap / 4)); //very long messages get truncated
+	size_t size = align8(sizeof(RecordHeader) + moduleLen + messageLen);
+
+	std::lock_guard<std::mutex> lock(writeMutex);
+	uint64_t w = header->writePos.load(std::memory_order_relaxed);
+	uint64_t r = header->readPos.load(std::memory_order_acquire);
+	size_t offset = w % cap;
+	size_t contiguous = cap - offset;
+	size_t needed = size + (contiguous < size ? contiguous : 0);
+	if(cap - (w - r) < needed){
+		header->dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	if(contiguous < size){ //not enough room until the end, pad and wrap around
+		RecordHeader * pad = (RecordHeader*)(data + offset);
+		pad->size = contiguous;
+		pad->flags = SUPERLOG_RING_WRAP;
+		w += contiguous;
+		offset = 0;
+	}
+	RecordHeader * rh = (RecordHeader*)(data + offset);
+	rh->size = size;
+	rh->flags = 0;
+	rh->timestamp = nowMicros(); //taken inside the lock so each ring is ordered
+	rh->messageLen = messageLen;
+	rh->moduleLen = moduleLen;
+	rh->level = level;
+	char * payload = (char*)(rh + 1);
+	memcpy(payload, module.data(), moduleLen);
+	memcpy(payload + moduleLen, message.data(), messageLen);
+	header->writePos.store(w + size, std::memory_order_release);
+	return true;
+}
+
+//the next unread record, skipping wrap padding. Anything in the ring is checked before it's used: the segment
+//is shared memory another process writes, a bad record must not make us read out of bounds or spin.
+//On a bad one everything unread is skipped. Call from the reader only.
+bool ofxSuperLogSharedRing::nextRecord(RecordView & v){
+	const uint64_t cap = capacity;
+	uint64_t r = header->readPos.load(std::memory_order_relaxed);
+	uint64_t w = header->writePos.load(std::memory_order_acquire);
+	while(r < w){
+		size_t offset = r % cap;
+		bool ok = w - r <= cap && offset % 8 == 0;
+		if(ok){
+			memcpy(&v.header, data + offset, 8); //size & flags; wrap padding may be just these
+			uint32_t size = v.header.size;
+			ok = size != 0 && size % 8 == 0 && size <= cap - offset && size <= w - r;
+			if(ok && (v.header.flags & SUPERLOG_RING_WRAP)){
+				r += size;
+				header->readPos.store(r, std::memory_order_release);
+				continue;
+			}
+			if(ok && size >= sizeof(RecordHeader)){
+				memcpy(&v.header, data + offset, sizeof(RecordHeader));
+				ok = v.header.size == size && sizeof(RecordHeader) + size_t(v.header.moduleLen) + v.header.messageLen <= size;
+			}else{
+				ok = false;
+			}
+		}
+		if(!ok){
+			numCorrupt++;
+			header->readPos.store(w, std::memory_order_release);
+			return false;
+		}
+		v.payload = data + offset + sizeof(RecordHeader);
+		return true;
+	}
+	return false;
+}
+
+bool ofxSuperLogSharedRing::peekTimestamp(uint64_t & timestamp){
+	if(!header) return false;
+	RecordView v;
+	if(!nextRecord(v)) return false;
+	timestamp = v.header.timestamp;
+	return true;
+}
+
+bool ofxSuperLogSharedRing::read(Record & rec){
+	if(!header) return false;
+	RecordView v;
+	if(!nextRecord(v)) return false;
+	rec.timestamp = v.header.timestamp;
+	rec.level = (ofLogLevel)std::min(int(v.header.level), int(OF_LOG_FATAL_ERROR));
+	rec.module.assign(v.payload, v.header.moduleLen);
+	rec.message.assign(v.payload + v.header.moduleLen, v.header.messageLen);
+	header->readPos.fetch_add(v.header.size, std::memory_order_release);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+ofxSuperLogSharedRingCollector::~ofxSuperLogSharedRingCollector(){
+	stop();
+}
+
+void ofxSuperLogSharedRingCollector::addSource(const string & name){
+	std::lock_guard<std::mutex> lock(sourcesMutex);
+	for(auto & s : sources){
+		if(s->name == name) return;
+	}
+	auto s = unique_ptr<Source>(new Source());
+	s->name = name;
+	sources.push_back(std::move(s));
+}
+
+void ofxSuperLogSharedRingCollector::start(Callback cb, int pollMs_, int mergeDelayMs_){
+	stop();
+	callback = cb;
+	pollMs = pollMs_;
+	mergeDelayMs = mergeDelayMs_;
+	running = true;
+	thread = std::thread(&ofxSuperLogSharedRingCollector::threadedFunction, this);
+}
+
+void ofxSuperLogSharedRingCollector::stop(){
+	running = false;
+	if(thread.joinable()) thread.join();
+}
+
+void ofxSuperLogSharedRingCollector::threadedFunction(){
+
+	ofxSuperLogSharedRing::Record rec;
+
+	while(running){
+		{
+			std::lock_guard<std::mutex> lock(sourcesMutex);
+
+			for(auto & s : sources){ //writers may start after us, keep trying
+				if(!s->ring){
+					auto ring = unique_ptr<ofxSuperLogSharedRing>(new ofxSuperLogSharedRing());
+					if(ring->attach(s->name)) s->ring = std::move(ring);
+				}
+			}
+
+			//k-way merge by timestamp
+			while(running){
+				Source * oldest = nullptr;
+				uint64_t oldestTime = 0;
+				bool someEmpty = false;
+				for(auto & s : sources){
+					uint64_t t;
+					if(s->ring && s->ring->peekTimestamp(t)){
+						if(!oldest || t < oldestTime){
+							oldest = s.get();
+							oldestTime = t;
+						}
+					}else{
+						someEmpty = true;
+					}
+				}
+				if(!oldest) break;
+				//an empty ring might still produce something older than what we have, give it some time
+				if(someEmpty && oldestTime + uint64_t(mergeDelayMs) * 1000 > ofxSuperLogSharedRing::nowMicros()) break;
+				if(oldest->ring->read(rec)){
+					callback(oldest->ring->getSourceLabel(), rec);
+				}
+			}
+
+			for(auto & s : sources){
+				if(!s->ring) continue;
+				uint64_t corrupt = s->ring->getNumCorrupt();
+				if(corrupt > s->reportedCorrupt){
+					ofxSuperLogSharedRing::Record warn;
+					warn.timestamp = ofxSuperLogSharedRing::nowMicros();
+					warn.level = OF_LOG_ERROR;
+					warn.module = "ofxSuperLog";
+					warn.message = "bad record in shared ring \"" + s->name + "\", skipped what was left in it";
+					callback(s->ring->getSourceLabel(), warn);
+					s->reportedCorrupt = corrupt;
+				}
+				uint64_t drops = s->ring->getNumDropped();
+				if(drops > s->reportedDrops){
+					ofxSuperLogSharedRing::Record warn;
+					warn.timestamp = ofxSuperLogSharedRing::nowMicros();
+					warn.level = OF_LOG_WARNING;
+					warn.module = "ofxSuperLog";
+					warn.message = ofToString(drops - s->reportedDrops) + " records dropped, shared ring \"" + s->name + "\" was full";
+					callback(s->ring->getSourceLabel(), warn);
+					s->reportedDrops = drops;
+				}
+				uint64_t t;
+				if(!s->ring->peekTimestamp(t) && s->ring->isWriterGone()){ //read it all and no more will come
+					s->ring->unlink();
+					s->ring.reset(); //attached again if the writer comes back
+					s->reportedDrops = s->reportedCorrupt = 0;
+				}
+			}
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
+	}
+}
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ *  ofxSuperLogSharedRing.h
+ *
+ *  Description:
+ *				Named POSIX shared-memory ring buffer of log records, so several processes can
+ *				send their logs to a single collector process that owns the log file.
+ *
+ *				Each writer process creates its own ring (one producer process, one consumer).
+ *				Threads inside the writer process are serialized by a local mutex; the collector
+ *				never blocks writers - if a ring is full, records are dropped and counted.
+ *
+ *				Segments are created 0600 (owner only) by default. The collector checks every record
+ *				before using it and starts over from the write position if one doesn't add up. A
+ *				segment is unlinked once its writer is gone (closed or dead) and everything in it was read.
+ *
+ *  Usage:
+ *				in each app:		ofxSuperLog::getLogger(true, true)->setSharedMemoryLogging("/myInstall.app1", "app1");
+ *				in the collector:	ofxSuperLog::getLogger(true, true, "logs")->addSharedMemorySource("/myInstall.app1");
+ *
+ *				Not available on Windows.
+ */
+
+#pragma once
+#include "ofMain.h"
+
+#ifndef TARGET_WIN32
+
+class ofxSuperLogSharedRing {
+public:
+
+	struct Record{
+		uint64_t timestamp; //microseconds since epoch, comparable across processes
+		ofLogLevel level;
+		string module;
+		string message;
+	};
+
+	ofxSuperLogSharedRing();
+	~ofxSuperLogSharedRing();
+
+	///writer side: creates (or re-uses) the named segment. name must start with '/'. mode: permissions of a new segment
+	bool create(const string & name, const string & sourceLabel, size_t capacityBytes = 4 * 1024 * 1024, mode_t mode = 0600);
+	///reader side: maps an existing segment. Returns false if the writer hasn't created it yet.
+	bool attach(const string & name);
+	void close(); //the writer unlinks the segment if the collector read it all, else it's left for the collector to unlink
+	bool isOpen(){return header != nullptr;}
+
+	//writer side. returns false if the record didn't fit (ring full) and was dropped
+	bool write(ofLogLevel level, const string & module, const string & message);
+
+	//reader side
+	bool peekTimestamp(uint64_t & timestamp); //timestamp of the oldest unread record
+	bool read(Record & r);
+	bool isWriterGone(); //closed or died, nothing more will come
+	void unlink(); //reader side, once drained & the writer is gone
+
+	string getName(){return name;}
+	string getSourceLabel();
+	uint64_t getNumDropped();
+	uint64_t getNumCorrupt(){return numCorrupt;} //reader side: times a bad record made us skip what was in the ring
+
+	static uint64_t nowMicros();
+
+protected:
+
+	struct Header;
+
+	bool map(int fd, size_t totalSize);
+	struct RecordView;
+	bool nextRecord(RecordView & v); //reader side, checked
+
+	string name;
+	bool owner = false;
+	Header * header = nullptr;
+	char * data = nullptr;
+	size_t mappedSize = 0;
+	uint64_t capacity = 0; //our copy, the shared header could be scribbled over
+	uint64_t numCorrupt = 0;
+	std::mutex writeMutex;
+};
+
+
+/// Merges several rings by timestamp. Runs its own thread and hands records to a callback
+/// in timestamp order. A record is only handed out once every live ring has something newer,
+/// or after mergeDelayMs have passed, so slightly late writers still interleave correctly.
+class ofxSuperLogSharedRingCollector {
+public:
+
+	typedef std::function<void(const string & sourceLabel, const ofxSuperLogSharedRing::Record &)> Callback;
+
+	~ofxSuperLogSharedRingCollector();
+
+	void addSource(const string & name);
+	void start(Callback cb, int pollMs = 10, int mergeDelayMs = 50);
+	void stop();
+
+protected:
+
+	void threadedFunction();
+
+	struct Source{
+		string name;
+		unique_ptr<ofxSuperLogSharedRing> ring;
+		uint64_t reportedDrops = 0;
+		uint64_t reportedCorrupt = 0;
+	};
+
+	vector<unique_ptr<Source>> sources;
+	std::mutex sourcesMutex;
+	Callback callback;
+	int pollMs = 10;
+	int mergeDelayMs = 50;
+	std::thread thread;
+	std::atomic<bool> running{false};
+};
+
+#endif
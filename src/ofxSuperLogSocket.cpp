@@ -0,0 +1,320 @@
+/**
+ *  ofxSuperLogSocket.cpp
+ *
+ */
+
+#include "ofxSuperLogSocket.h"
+
+#ifndef TARGET_WIN32
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#ifndef MSG_NOSIGNAL
+	#define MSG_NOSIGNAL 0 //osx, we use SO_NOSIGPIPE instead
+#endif
+
+#define SUPERLOG_SOCKET_MAX_BACKOFF_MS 5000
+#define SUPERLOG_SOCKET_SPOOL_CHUNK (256 * 1024) //how much of the spool we hold in memory when sending it
+
+//frames are written in host order, which is little endian on every platform we ship on
+static void appendFrame(vector<char> & buf, ofLogLevel level, const string & module, const string & message){
+	uint64_t ts = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	uint16_t moduleLen = std::min(module.size(), size_t(UINT16_MAX));
+	uint8_t lev = level;
+	uint32_t frameLen = sizeof(ts) + sizeof(lev) + sizeof(moduleLen) + moduleLen + message.size();
+	size_t start = buf.size();
+	buf.resize(start + sizeof(frameLen) + frameLen);
+	char * p = buf.data() + start;
+	memcpy(p, &frameLen, sizeof(frameLen)); p += sizeof(frameLen);
+	memcpy(p, &ts, sizeof(ts)); p += sizeof(ts);
+	memcpy(p, &lev, sizeof(lev)); p += sizeof(lev);
+	memcpy(p, &moduleLen, sizeof(moduleLen)); p += sizeof(moduleLen);
+	memcpy(p, module.data(), moduleLen); p += moduleLen;
+	memcpy(p, message.data(), message.size());
+}
+
+static size_t frameSize(const char * p){
+	uint32_t len;
+	memcpy(&len, p, sizeof(len));
+	return sizeof(len) + len;
+}
+
+static uint64_t countFrames(const char * p, size_t size){
+	uint64_t n = 0;
+	for(size_t off = 0; off < size; off += frameSize(p + off)) n++;
+	return n;
+}
+
+static uint64_t nowMillis(){
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ofxSuperLogSocket::~ofxSuperLogSocket(){
+	close();
+}
+
+void ofxSuperLogSocket::setup(const string & socketPath_, bool datagram_, const string & spoolPath_, size_t maxBatchBytes_, int maxBatchMs_, size_t maxSpoolBytes_){
+	close();
+	socketPath = socketPath_;
+	datagram = datagram_;
+	spoolPath = spoolPath_.size() ? ofToDataPath(spoolPath_, true) : "";
+	maxBatchBytes = std::max(maxBatchBytes_, size_t(256));
+	if(datagram) maxBatchBytes = std::min(maxBatchBytes, size_t(64 * 1024)); //keep under the default socket buffers
+	maxBatchMs = std::max(maxBatchMs_, 1);
+	maxSpoolBytes = maxSpoolBytes_;
+	pending.reserve(maxBatchBytes * 2);
+	spoolHasData = false;
+	spoolBytes = 0;
+	if(spoolPath.size()){ //leftovers from a previous run go out first
+		FILE * f = fopen(spoolPath.c_str(), "rb");
+		if(f){
+			fseek(f, 0, SEEK_END);
+			long size = ftell(f);
+			spoolBytes = size > 0 ? size : 0;
+			spoolHasData = spoolBytes > 0;
+			fclose(f);
+		}
+	}
+	running = true;
+	thread = std::thread(&ofxSuperLogSocket::threadedFunction, this);
+}
+
+void ofxSuperLogSocket::close(){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(!running) return;
+		running = false;
+	}
+	condition.notify_all();
+	if(thread.joinable()) thread.join();
+	disconnect();
+}
+
+void ofxSuperLogSocket::log(ofLogLevel level, const string & module, const string & message){
+	std::unique_lock<std::mutex> lock(mutex);
+	if(!running) return;
+	if(pending.size() > maxPendingBytes){
+		numDropped++;
+		return;
+	}
+	appendFrame(pending, level, module, message);
+	if(pending.size() >= maxBatchBytes){
+		lock.unlock();
+		condition.notify_one();
+	}
+}
+
+bool ofxSuperLogSocket::connect(){
+	if(fd >= 0) return true;
+	uint64_t now = nowMillis();
+	if(now < nextConnectAttempt) return false;
+
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+	fd = socket(AF_UNIX, datagram ? SOCK_DGRAM : SOCK_STREAM, 0);
+	if(fd >= 0){
+		#ifdef SO_NOSIGPIPE
+		int one = 1;
+		setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+		#endif
+		timeval tv = {1, 0}; //a stuck collector shouldn't hold our batches forever
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+		if(::connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0){
+			connectBackoffMs = 100;
+			connected = true;
+			return true;
+		}
+		::close(fd);
+		fd = -1;
+	}
+	nextConnectAttempt = now + connectBackoffMs;
+	connectBackoffMs = std::min(connectBackoffMs * 2, SUPERLOG_SOCKET_MAX_BACKOFF_MS);
+	return false;
+}
+
+void ofxSuperLogSocket::disconnect(){
+	if(fd >= 0) ::close(fd);
+	fd = -1;
+	connected = false;
+}
+
+//sends as many whole frames as it can; returns how many bytes (frame aligned) made it through
+static size_t sendFrames(int fd, bool datagram, size_t maxBatchBytes, const char * data, size_t size, std::atomic<uint64_t> & numDropped, bool & ok){
+	ok = true;
+	size_t done = 0;
+	if(datagram){
+		while(done < size){
+			size_t chunk = 0;
+			while(done + chunk < size && (chunk == 0 || chunk + frameSize(data + done + chunk) <= maxBatchBytes)){
+				chunk += frameSize(data + done + chunk);
+			}
+			if(::send(fd, data + done, chunk, MSG_NOSIGNAL) < 0){
+				if(errno == EMSGSIZE){ //a single huge frame, no point in retrying it
+					numDropped++;
+				}else{
+					ok = false;
+					return done;
+				}
+			}
+			done += chunk;
+		}
+		return done;
+	}
+
+	size_t sent = 0;
+	while(sent < size){
+		ssize_t r = ::send(fd, data + sent, size - sent, MSG_NOSIGNAL);
+		if(r <= 0){
+			if(r < 0 && errno == EINTR) continue;
+			ok = false;
+			break;
+		}
+		sent += r;
+	}
+	if(ok) return size;
+	//the collector drops the partial frame at the end of a dead stream, resend it later
+	while(done < size && done + frameSize(data + done) <= sent) done += frameSize(data + done);
+	return done;
+}
+
+bool ofxSuperLogSocket::send(const vector<char> & bytes){
+	bool ok;
+	size_t done = sendFrames(fd, datagram, maxBatchBytes, bytes.data(), bytes.size(), numDropped, ok);
+	if(!ok){
+		disconnect();
+		vector<char> rest(bytes.begin() + done, bytes.end());
+		spool(rest);
+	}
+	return ok;
+}
+
+//sends the spool a chunk at a time, so a big backlog doesn't have to fit in memory
+bool ofxSuperLogSocket::sendSpool(){
+	FILE * f = fopen(spoolPath.c_str(), "rb");
+	if(!f){
+		spoolHasData = false;
+		spoolBytes = 0;
+		return true;
+	}
+	vector<char> & bytes = spoolChunk;
+	bytes.clear();
+	size_t offset = 0; //spool offset of bytes[0]
+	bool eof = false;
+	while(true){
+		//top up to a chunk, or to the whole of the first frame if it's bigger than that
+		size_t want = SUPERLOG_SOCKET_SPOOL_CHUNK;
+		if(bytes.size() >= sizeof(uint32_t)) want = std::max(want, frameSize(bytes.data()));
+		if(!eof && bytes.size() < want){
+			size_t have = bytes.size();
+			bytes.resize(want);
+			size_t n = fread(bytes.data() + have, 1, want - have, f);
+			bytes.resize(have + n);
+			eof = n < want - have;
+		}
+
+		size_t whole = 0;
+		while(whole + sizeof(uint32_t) <= bytes.size() && whole + frameSize(bytes.data() + whole) <= bytes.size()){
+			whole += frameSize(bytes.data() + whole);
+		}
+		if(whole == 0){
+			if(eof) break; //empty, or a frame cut short by a crash while spooling
+			if(frameSize(bytes.data()) > maxSpoolBytes + sizeof(uint32_t)){ //can't be ours, the rest is garbage
+				ofLogError("ofxSuperLogSocket") << "spool \"" << spoolPath << "\" is corrupt, dropping it";
+				break;
+			}
+			continue; //read the rest of a frame bigger than a chunk
+		}
+
+		bool ok;
+		size_t done = sendFrames(fd, datagram, maxBatchBytes, bytes.data(), whole, numDropped, ok);
+		if(!ok){
+			disconnect();
+			bool kept = keepSpoolFrom(f, offset + done);
+			fclose(f);
+			bytes.clear();
+			if(!kept) remove(spoolPath.c_str());
+			return false;
+		}
+		bytes.erase(bytes.begin(), bytes.begin() + whole);
+		offset += whole;
+	}
+	fclose(f);
+	bytes.clear();
+	if(bytes.capacity() > SUPERLOG_SOCKET_SPOOL_CHUNK) vector<char>().swap(bytes); //after an oversized frame
+	remove(spoolPath.c_str());
+	spoolHasData = false;
+	spoolBytes = 0;
+	return true;
+}
+
+bool ofxSuperLogSocket::keepSpoolFrom(FILE * f, size_t offset){
+	string tmpPath = spoolPath + ".tmp";
+	FILE * out = fopen(tmpPath.c_str(), "wb");
+	if(!out || fseek(f, offset, SEEK_SET) != 0){
+		if(out) fclose(out);
+		ofLogError("ofxSuperLogSocket") << "couldn't rewrite spool \"" << spoolPath << "\", dropping it";
+		spoolHasData = false;
+		spoolBytes = 0;
+		return false;
+	}
+	char chunk[64 * 1024];
+	size_t n, kept = 0;
+	while((n = fread(chunk, 1, sizeof(chunk), f)) > 0) kept += fwrite(chunk, 1, n, out);
+	fclose(out);
+	rename(tmpPath.c_str(), spoolPath.c_str());
+	spoolBytes = kept;
+	spoolHasData = kept > 0;
+	return true;
+}
+
+void ofxSuperLogSocket::spool(const vector<char> & bytes){
+	if(bytes.empty()) return;
+	FILE * f = spoolPath.size() ? fopen(spoolPath.c_str(), "ab") : nullptr;
+	if(!f){
+		numDropped += countFrames(bytes.data(), bytes.size());
+		return;
+	}
+	//only whole frames go in, the ones past maxSpoolBytes are dropped
+	size_t fits = 0;
+	while(fits < bytes.size() && spoolBytes + fits + frameSize(bytes.data() + fits) <= maxSpoolBytes){
+		fits += frameSize(bytes.data() + fits);
+	}
+	numDropped += countFrames(bytes.data() + fits, bytes.size() - fits);
+	size_t written = fwrite(bytes.data(), 1, fits, f);
+	fclose(f);
+	spoolBytes += written;
+	spoolHasData = spoolBytes > 0;
+}
+
+void ofxSuperLogSocket::threadedFunction(){
+
+	std::unique_lock<std::mutex> lock(mutex);
+	bool exiting = false;
+	while(!exiting){
+		condition.wait_for(lock, std::chrono::milliseconds(maxBatchMs), [this]{
+			return !running || pending.size() >= maxBatchBytes;
+		});
+		exiting = !running;
+		if(pending.empty() && !spoolHasData) continue;
+		sending.swap(pending);
+		lock.unlock();
+
+		//spooled records are older, they must go first to keep the order
+		if(connect() && (!spoolHasData || sendSpool())){
+			if(sending.size()) send(sending);
+		}else{
+			spool(sending);
+		}
+		sending.clear();
+
+		lock.lock();
+	}
+}
+
+#endif
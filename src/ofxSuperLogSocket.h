@@ -0,0 +1,79 @@
+/**
+ *  ofxSuperLogSocket.h
+ *
+ *  Description:
+ *				Sends log records to a collector daemon on the same machine over a Unix-domain
+ *				socket (stream or datagram). log() only appends to an in-memory batch; a background
+ *				thread sends batches when they reach maxBatchBytes or get older than maxBatchMs,
+ *				reconnects when the collector goes away, and spools to a local file meanwhile.
+ *				The spool is sent ahead of new records once the collector is back, read back in
+ *				bounded chunks; once it reaches maxSpoolBytes, further records are dropped and counted.
+ *
+ *				Wire format, one frame per record, all integers little endian:
+ *					uint32 frameLen (bytes after this field) | uint64 timestamp (us since epoch) |
+ *					uint8 level | uint16 moduleLen | module | message
+ *				Datagram sockets get whole frames only, one batch per datagram.
+ *
+ *				See tools/ofxSuperLogSocketCollector for a minimal collector.
+ *				Not available on Windows.
+ */
+
+#pragma once
+#include "ofMain.h"
+
+#ifndef TARGET_WIN32
+
+class ofxSuperLogSocket {
+public:
+
+	~ofxSuperLogSocket();
+
+	///spoolPath can be empty, in which case records are dropped while the collector is down.
+	///The spool never grows past maxSpoolBytes; records that don't fit are dropped.
+	void setup(const string & socketPath, bool datagram, const string & spoolPath,
+			   size_t maxBatchBytes = 16 * 1024, int maxBatchMs = 100, size_t maxSpoolBytes = 64 * 1024 * 1024);
+	void close();
+
+	//never blocks on the socket
+	void log(ofLogLevel level, const string & module, const string & message);
+
+	bool isConnected(){return connected;}
+	uint64_t getNumDropped(){return numDropped;}
+
+	size_t maxPendingBytes = 8 * 1024 * 1024; //beyond this, records are dropped
+
+protected:
+
+	void threadedFunction();
+	bool connect();
+	void disconnect();
+	bool send(const vector<char> & bytes); //whole batch, respecting frame boundaries for datagrams
+	bool sendSpool();
+	void spool(const vector<char> & bytes);
+	bool keepSpoolFrom(FILE * f, size_t offset); //rewrites the spool with what's left after offset
+
+	string socketPath;
+	string spoolPath;
+	bool datagram = false;
+	size_t maxBatchBytes = 16 * 1024;
+	int maxBatchMs = 100;
+	size_t maxSpoolBytes = 64 * 1024 * 1024;
+
+	vector<char> pending;
+	vector<char> sending;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::thread thread;
+	bool running = false;
+
+	int fd = -1;
+	std::atomic<bool> connected{false};
+	std::atomic<uint64_t> numDropped{0};
+	uint64_t nextConnectAttempt = 0;
+	int connectBackoffMs = 100;
+	bool spoolHasData = false;
+	size_t spoolBytes = 0;
+	vector<char> spoolChunk;
+};
+
+#endif
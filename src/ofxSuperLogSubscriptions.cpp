@@ -0,0 +1,155 @@
+/**
+ *  ofxSuperLogSubscriptions.cpp
+ *
+ */
+
+#include "ofxSuperLogSubscriptions.h"
+
+ofxSuperLogSubscriptions::~ofxSuperLogSubscriptions(){
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		running = false;
+	}
+	condition.notify_all();
+	dispatchedCondition.notify_all();
+	if(thread.joinable()) thread.join();
+}
+
+int ofxSuperLogSubscriptions::subscribe(Callback cb, ofLogLevel minLevel, const vector<string> & modules){
+	std::lock_guard<std::mutex> lock(subscribersMutex);
+	auto s = make_shared<Subscriber>();
+	s->id = nextId++;
+	s->callback = cb;
+	s->minLevel = minLevel;
+	s->modules.insert(modules.begin(), modules.end());
+	subscribers.push_back(s);
+	compileFilter();
+
+	std::lock_guard<std::mutex> pendingLock(pendingMutex);
+	if(!running){
+		running = true;
+		thread = std::thread(&ofxSuperLogSubscriptions::threadedFunction, this);
+	}
+	return s->id;
+}
+
+void ofxSuperLogSubscriptions::unsubscribe(int id){
+	{
+		std::lock_guard<std::mutex> lock(subscribersMutex);
+		subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(), [id](const shared_ptr<Subscriber> & s){
+			return s->id == id;
+		}), subscribers.end());
+		compileFilter();
+	}
+	//a dispatch that started before the erase might still call it, wait for it to end
+	bool fromCallback;
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		fromCallback = std::this_thread::get_id() == thread.get_id();
+	}
+	if(!fromCallback){
+		std::lock_guard<std::mutex> lock(dispatchMutex);
+	}
+}
+
+void ofxSuperLogSubscriptions::flush(){
+	std::unique_lock<std::mutex> lock(pendingMutex);
+	if(!running || std::this_thread::get_id() == thread.get_id()) return;
+	uint64_t target = numQueued;
+	dispatchedCondition.wait(lock, [&]{ return numDispatched >= target || !running; });
+}
+
+void ofxSuperLogSubscriptions::compileFilter(){
+	auto f = unique_ptr<Filter>(new Filter());
+	for(auto & s : subscribers){
+		f->minLevel = std::min(f->minLevel, int(s->minLevel));
+		if(s->modules.empty()) f->allModules = true;
+		else f->modules.insert(s->modules.begin(), s->modules.end());
+	}
+	if(f->allModules) f->modules.clear();
+	filter.store(f.get());
+
+	//log() calls from now on register in the new epoch and can only see the new filter.
+	//Once the old epoch is empty nobody is looking at the old one. Each call is short, this doesn't wait long.
+	unsigned old = filterEpoch++;
+	while(numFilterReaders[old & 1].load() != 0){
+		std::this_thread::yield();
+	}
+	currentFilter = std::move(f);
+}
+
+void ofxSuperLogSubscriptions::push(const ofxSuperLogBatch & batch, uint64_t time){
+	FilterReader reader(*this);
+	const Filter * f = filter.load();
+	std::unique_lock<std::mutex> lock(pendingMutex, std::defer_lock);
+	for(size_t i = 0; i < batch.size(); i++){
+		const ofxSuperLogBatch::Line & l = batch[i];
+		if(l.level < f->minLevel) continue;
+		if(!f->allModules && !f->modules.count(l.module)) continue;
+		if(!lock.owns_lock()) lock.lock();
+		append(l.level, l.module, l.message, time);
+	}
+}
+
+void ofxSuperLogSubscriptions::enqueue(ofLogLevel level, const string & module, const string & message, uint64_t time){
+	std::lock_guard<std::mutex> lock(pendingMutex);
+	append(level, module, message, time);
+}
+
+void ofxSuperLogSubscriptions::append(ofLogLevel level, const string & module, const string & message, uint64_t time){
+	if(pending.size() >= maxPending){
+		numDropped++;
+		return;
+	}
+	if(pending.empty()) condition.notify_one(); //the dispatch thread only waits when there's nothing left
+	numQueued++;
+	pending.push_back(Record());
+	Record & r = pending.back();
+	r.level = level;
+	r.module = module;
+	r.message = message;
+	r.time = time;
+	r.thread = ofxSuperLogThread::current();
+}
+
+void ofxSuperLogSubscriptions::threadedFunction(){
+
+	ofxSuperLogThread::setName("ofxSuperLogDispatch");
+	vector<Record> batch;
+	vector<Record> matching;
+	vector<shared_ptr<Subscriber>> subs;
+
+	std::unique_lock<std::mutex> lock(pendingMutex);
+	while(true){
+		condition.wait(lock, [&]{ return !running || pending.size(); });
+		if(pending.empty()) break; //stopped, and what was left has been sent
+		batch.swap(pending);
+		lock.unlock();
+
+		std::unique_lock<std::mutex> dispatchLock(dispatchMutex);
+		{
+			std::lock_guard<std::mutex> subsLock(subscribersMutex);
+			subs = subscribers;
+		}
+		for(auto & s : subs){
+			bool all = s->minLevel == OF_LOG_VERBOSE && s->modules.empty();
+			if(!all){
+				matching.clear();
+				for(auto & r : batch){
+					if(r.level >= s->minLevel && (s->modules.empty() || s->modules.count(r.module))){
+						matching.push_back(r);
+					}
+				}
+			}
+			const vector<Record> & out = all ? batch : matching;
+			if(out.size()) s->callback(out);
+		}
+		subs.clear();
+		dispatchLock.unlock();
+
+		lock.lock();
+		numDispatched += batch.size();
+		batch.clear();
+		dispatchedCondition.notify_all();
+	}
+}
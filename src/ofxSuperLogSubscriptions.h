@@ -0,0 +1,122 @@
+/**
+ *  ofxSuperLogSubscriptions.h
+ *
+ *  Description:
+ *				Lets the app react to log records (count errors, show an alert, poke a watchdog...)
+ *				without writing a logger channel. Subscribers get batches of matching records on a
+ *				dedicated dispatch thread, so a slow subscriber never slows down log() callers.
+ *
+ *				Level and module filters are compiled into a single immutable filter on (un)subscribe;
+ *				records that no subscriber wants are rejected in log() without taking any lock. log()
+ *				calls register in the current epoch; (un)subscribe starts a new one and waits for the
+ *				calls of the previous one to leave before freeing the filter they might be using.
+ *
+ *				The dispatch thread wakes up as soon as there is something to send; records logged
+ *				while it's busy go out together in the next batch. Records still queued when the
+ *				logger is destroyed are dispatched before the thread stops.
+ *
+ *  Usage:
+ *				ofxSuperLog::getLogger()->subscribe([](const vector<ofxSuperLogSubscriptions::Record> & records){
+ *					numErrors += records.size();
+ *				}, OF_LOG_ERROR);
+ */
+
+#pragma once
+#include "ofMain.h"
+#include "ofxSuperLogThread.h"
+#include "ofxSuperLogBatch.h"
+#include <unordered_set>
+
+class ofxSuperLogSubscriptions {
+public:
+
+	struct Record{
+		ofLogLevel level;
+		string module;
+		string message;
+		uint64_t time; //ofxSuperLogClock::now()
+		ofxSuperLogThread::Info thread;
+	};
+
+	typedef std::function<void(const vector<Record> &)> Callback;
+
+	~ofxSuperLogSubscriptions();
+
+	///modules empty means all modules. Returns an id for unsubscribe().
+	int subscribe(Callback cb, ofLogLevel minLevel = OF_LOG_VERBOSE, const vector<string> & modules = vector<string>());
+	///once this returns, the callback isn't running and won't be called again (unless called from the callback itself)
+	void unsubscribe(int id);
+
+	///blocks until everything pushed before the call was handed to the subscribers
+	void flush();
+
+	///called from log(), any thread
+	void push(ofLogLevel level, const string & module, const string & message, uint64_t time){
+		FilterReader reader(*this);
+		const Filter * f = filter.load();
+		if(level < f->minLevel) return;
+		if(!f->allModules && !f->modules.count(module)) return;
+		enqueue(level, module, message, time);
+	}
+	///same for a whole batch, one lock (if any record passes)
+	void push(const ofxSuperLogBatch & batch, uint64_t time);
+
+	size_t maxPending = 100000; //records; beyond this, they are dropped
+	uint64_t getNumDropped(){return numDropped;}
+
+protected:
+
+	struct Filter{
+		int minLevel = OF_LOG_SILENT + 1; //nothing passes
+		bool allModules = false;
+		std::unordered_set<string> modules;
+	};
+
+	struct Subscriber{
+		int id;
+		Callback callback;
+		ofLogLevel minLevel;
+		std::unordered_set<string> modules;
+	};
+
+	//a log() call looking at the filter, counted in its epoch
+	struct FilterReader{
+		FilterReader(ofxSuperLogSubscriptions & s):s(s){
+			while(true){
+				epoch = s.filterEpoch.load();
+				s.numFilterReaders[epoch & 1]++;
+				if(s.filterEpoch.load() == epoch) break;
+				s.numFilterReaders[epoch & 1]--; //a new epoch started meanwhile, join that one
+			}
+		}
+		~FilterReader(){ s.numFilterReaders[epoch & 1]--; }
+		ofxSuperLogSubscriptions & s;
+		unsigned epoch;
+	};
+
+	void enqueue(ofLogLevel level, const string & module, const string & message, uint64_t time);
+	void append(ofLogLevel level, const string & module, const string & message, uint64_t time); //call with pendingMutex locked
+	void compileFilter(); //call with subscribersMutex locked
+	void threadedFunction();
+
+	std::atomic<const Filter*> filter{&emptyFilter};
+	Filter emptyFilter;
+	unique_ptr<Filter> currentFilter;
+	std::atomic<unsigned> filterEpoch{0};
+	std::atomic<int> numFilterReaders[2] = {{0}, {0}};
+
+	vector<shared_ptr<Subscriber>> subscribers;
+	std::mutex subscribersMutex;
+	std::mutex dispatchMutex; //held while callbacks run
+	int nextId = 1;
+
+	vector<Record> pending;
+	std::mutex pendingMutex;
+	std::condition_variable condition;
+	std::condition_variable dispatchedCondition;
+	uint64_t numQueued = 0; //records that made it into pending, ever
+	uint64_t numDispatched = 0;
+	std::thread thread;
+	bool running = false;
+	std::atomic<uint64_t> numDropped{0};
+};
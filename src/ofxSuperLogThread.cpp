@@ -0,0 +1,37 @@
+/**
+ *  ofxSuperLogThread.cpp
+ *
+ */
+
+#include "ofxSuperLogThread.h"
+#include <set>
+
+ofxSuperLogThread::Info ofxSuperLogThread::makeInfo(){
+	static std::atomic<uint32_t> nextId(1);
+	Info info;
+	info.id = nextId++;
+	return info;
+}
+
+const string * ofxSuperLogThread::intern(const string & name){
+	//set nodes never move, so the pointers stay valid. Never destroyed either: the logger may outlive
+	//this translation unit's statics at exit, and still has records pointing at these names
+	static std::set<string> * names = new std::set<string>();
+	static std::mutex * mutex = new std::mutex();
+	std::lock_guard<std::mutex> lock(*mutex);
+	return &*names->insert(name).first;
+}
+
+void ofxSuperLogThread::setName(const string & name){
+	currentInfo().name = name.size() ? intern(name) : nullptr;
+}
+
+string ofxSuperLogThread::getTag(const Info & info){
+	return getTag(info.id, info.name);
+}
+
+string ofxSuperLogThread::getTag(uint32_t id, const string * name){
+	string tag = "T" + ofToString(id);
+	if(name) tag += ":" + *name;
+	return tag;
+}
@@ -0,0 +1,44 @@
+/**
+ *  ofxSuperLogThread.h
+ *
+ *  Description:
+ *				Compact per-thread identity for log records. Each thread gets a small sequential id
+ *				the first time it logs, and can be given a name; both live in thread local storage,
+ *				so tagging a record costs no syscall. Names are interned once and never freed.
+ *
+ *  Usage:
+ *				in your thread function:	ofxSuperLogThread::setName("videoDecoder");
+ */
+
+#pragma once
+#include "ofMain.h"
+
+class ofxSuperLogThread {
+public:
+
+	struct Info{
+		uint32_t id = 0;
+		const string * name = nullptr; //interned, stays valid forever
+	};
+
+	///info for the calling thread
+	static const Info & current(){
+		return currentInfo();
+	}
+
+	///names the calling thread
+	static void setName(const string & name);
+
+	///"T3" or "T3:videoDecoder"
+	static string getTag(const Info & info);
+	static string getTag(uint32_t id, const string * name);
+
+protected:
+
+	static Info & currentInfo(){
+		static thread_local Info info = makeInfo();
+		return info;
+	}
+	static Info makeInfo();
+	static const string * intern(const string & name);
+};
@@ -0,0 +1,331 @@
+/**
+ *  ofxSuperLogUring.cpp
+ *
+ */
+
+#include "ofxSuperLogUring.h"
+
+#ifdef SUPERLOG_IO_URING
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#define SUPERLOG_URING_ENTRIES 64
+
+static int uringSetup(unsigned entries, struct io_uring_params * p){
+	return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags){
+	return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+static int uringRegister(int ringFd, unsigned opcode, const void * arg, unsigned nrArgs){
+	return (int)syscall(__NR_io_uring_register, ringFd, opcode, arg, nrArgs);
+}
+
+bool ofxSuperLogUring::isAvailable(){
+	static bool available = []{
+		struct io_uring_params p;
+		memset(&p, 0, sizeof(p));
+		int ringFd = uringSetup(4, &p);
+		if(ringFd < 0) return false; //ENOSYS, or EPERM when a seccomp profile blocks it
+		::close(ringFd);
+		return true;
+	}();
+	return available;
+}
+
+ofxSuperLogUring::~ofxSuperLogUring(){
+	close();
+}
+
+bool ofxSuperLogUring::setupRing(unsigned entries){
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	ringFd = uringSetup(entries, &p);
+	if(ringFd < 0) return false;
+
+	//mapped separately, which works whether or not the kernel shares the sq & cq rings
+	sqPtrSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	cqPtrSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+	sqPtr = mmap(nullptr, sqPtrSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+	cqPtr = mmap(nullptr, cqPtrSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+	void * sqesPtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+	if(sqPtr == MAP_FAILED) sqPtr = nullptr;
+	if(cqPtr == MAP_FAILED) cqPtr = nullptr;
+	if(sqesPtr != MAP_FAILED) sqes = (struct io_uring_sqe *)sqesPtr;
+	if(!sqPtr || !cqPtr || !sqes){
+		destroyRing();
+		return false;
+	}
+
+	char * sq = (char *)sqPtr;
+	sqHead = (unsigned *)(sq + p.sq_off.head);
+	sqTail = (unsigned *)(sq + p.sq_off.tail);
+	sqMask = (unsigned *)(sq + p.sq_off.ring_mask);
+	sqArray = (unsigned *)(sq + p.sq_off.array);
+	sqEntries = p.sq_entries;
+	char * cq = (char *)cqPtr;
+	cqHead = (unsigned *)(cq + p.cq_off.head);
+	cqTail = (unsigned *)(cq + p.cq_off.tail);
+	cqMask = (unsigned *)(cq + p.cq_off.ring_mask);
+	cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+	cqEntries = p.cq_entries;
+	return true;
+}
+
+void ofxSuperLogUring::destroyRing(){
+	if(sqes) munmap(sqes, sqesSize);
+	if(cqPtr) munmap(cqPtr, cqPtrSize);
+	if(sqPtr) munmap(sqPtr, sqPtrSize);
+	sqes = nullptr;
+	cqPtr = sqPtr = nullptr;
+	if(ringFd >= 0) ::close(ringFd);
+	ringFd = -1;
+}
+
+bool ofxSuperLogUring::open(const string & path, bool append, size_t bufferBytes, int numBuffers){
+	close();
+	if(!isAvailable()) return false;
+
+	fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? 0 : O_TRUNC), 0644);
+	if(fd < 0) return false;
+	struct stat st;
+	nextOffset = fstat(fd, &st) == 0 ? st.st_size : 0; //we write at explicit offsets, not O_APPEND, so slices can complete in any order
+	if(!setupRing(SUPERLOG_URING_ENTRIES)){
+		::close(fd);
+		fd = -1;
+		return false;
+	}
+
+	bufferSize = std::max(bufferBytes, size_t(4096));
+	numBuffers = std::max(numBuffers, 2);
+	memory.assign(bufferSize * numBuffers, 0);
+	buffers.assign(numBuffers, Buffer());
+	vector<struct iovec> iovs(numBuffers);
+	for(int i = 0; i < numBuffers; i++){
+		buffers[i].data = memory.data() + i * bufferSize;
+		iovs[i].iov_base = buffers[i].data;
+		iovs[i].iov_len = bufferSize;
+	}
+	//pinned memory counts against RLIMIT_MEMLOCK on older kernels; plain (still async) writes if it doesn't fit
+	registeredBuffers = uringRegister(ringFd, IORING_REGISTER_BUFFERS, iovs.data(), numBuffers) == 0;
+	current = 0;
+
+	ops.assign(cqEntries, Op()); //never more in flight than the completion queue holds
+	freeOps.clear();
+	for(auto & op : ops) freeOps.push_back(&op);
+	numInFlight = 0;
+	stopping = false;
+	failed = false;
+
+	reaper = std::thread(&ofxSuperLogUring::reap, this);
+	return true;
+}
+
+void ofxSuperLogUring::close(){
+	if(fd < 0) return;
+	flush(false);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true; //nothing in flight, the reaper is waiting on queued
+	}
+	queued.notify_all();
+	reaper.join();
+	if(registeredBuffers) uringRegister(ringFd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+	destroyRing();
+	::close(fd);
+	fd = -1;
+	buffers.clear();
+	memory.clear();
+	ops.clear();
+	freeOps.clear();
+}
+
+void ofxSuperLogUring::write(const char * data, size_t len){
+	if(fd < 0) return;
+	while(len){
+		Buffer & b = buffers[current];
+		if(b.fill == bufferSize){
+			nextBuffer();
+			continue;
+		}
+		size_t n = std::min(len, bufferSize - b.fill); //the part past fill is never in flight
+		memcpy(b.data + b.fill, data, n);
+		b.fill += n;
+		data += n;
+		len -= n;
+	}
+}
+
+void ofxSuperLogUring::submit(){
+	if(fd < 0) return;
+	Buffer & b = buffers[current];
+	if(b.fill == b.submitted) return;
+	std::unique_lock<std::mutex> lock(mutex);
+	completed.wait(lock, [this]{return freeOps.size() > 0;});
+	Op * op = freeOps.back();
+	freeOps.pop_back();
+	op->buffer = current;
+	op->start = b.submitted;
+	op->len = b.fill - b.submitted;
+	op->offset = nextOffset;
+	nextOffset += op->len;
+	b.submitted = b.fill;
+	b.inFlight++;
+	numInFlight++;
+	queue(op);
+}
+
+void ofxSuperLogUring::nextBuffer(){
+	submit();
+	current = (current + 1) % buffers.size();
+	std::unique_lock<std::mutex> lock(mutex);
+	completed.wait(lock, [this]{return buffers[current].inFlight == 0;}); //the only place we wait on the disk
+	buffers[current].fill = buffers[current].submitted = 0;
+}
+
+void ofxSuperLogUring::flush(bool sync){
+	if(fd < 0) return;
+	submit();
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		completed.wait(lock, [this]{return numInFlight == 0;});
+	}
+	if(sync) fdatasync(fd);
+}
+
+void ofxSuperLogUring::queue(Op * op){
+
+	if(failed){
+		writeInline(op);
+		return;
+	}
+
+	unsigned tail = *sqTail; //only we write it
+	unsigned idx = tail & *sqMask;
+	struct io_uring_sqe & sqe = sqes[idx];
+	memset(&sqe, 0, sizeof(sqe));
+	char * data = buffers[op->buffer].data + op->start;
+	if(registeredBuffers){
+		sqe.opcode = IORING_OP_WRITE_FIXED;
+		sqe.addr = (uint64_t)data;
+		sqe.len = op->len;
+		sqe.buf_index = op->buffer;
+	}else{
+		op->iov.iov_base = data;
+		op->iov.iov_len = op->len;
+		sqe.opcode = IORING_OP_WRITEV;
+		sqe.addr = (uint64_t)&op->iov;
+		sqe.len = 1;
+	}
+	sqe.fd = fd;
+	sqe.off = op->offset;
+	sqe.user_data = (uint64_t)op;
+	sqArray[idx] = idx;
+	__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+	//the kernel consumes the entries on submit (the writes themselves go on in the background), so the
+	//submission queue never fills up: at most cqEntries ops are in flight and each is submitted right away
+	while(true){
+		unsigned toSubmit = *sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+		if(toSubmit == 0) break;
+		int n = uringEnter(ringFd, toSubmit, 0, 0);
+		if(n > 0) continue;
+		if(n < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY)){
+			std::this_thread::yield();
+			continue;
+		}
+		//the ring is broken: take the entry back (the kernel didn't consume it) and write it ourselves.
+		//Every op after this one does the same, the owner sees hasFailed() and moves to stdio.
+		__atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+		failed = true;
+		writeInline(op);
+		break;
+	}
+	queued.notify_one();
+}
+
+void ofxSuperLogUring::writeInline(Op * op){
+	pwriteAll(buffers[op->buffer].data + op->start, op->len, op->offset);
+	numFallbackWrites++;
+	buffers[op->buffer].inFlight--;
+	numInFlight--;
+	freeOps.push_back(op);
+	completed.notify_all();
+}
+
+void ofxSuperLogUring::pwriteAll(const char * data, size_t len, uint64_t offset){
+	size_t done = 0;
+	while(done < len){
+		ssize_t n = pwrite(fd, data + done, len - done, offset + done);
+		if(n < 0 && errno == EINTR) continue;
+		if(n <= 0) break;
+		done += n;
+	}
+}
+
+void ofxSuperLogUring::reap(){
+
+	while(true){
+		{
+			//only block in the kernel while it has something of ours, so close() never needs to submit anything to stop us
+			std::unique_lock<std::mutex> lock(mutex);
+			queued.wait(lock, [this]{return numInFlight > 0 || stopping;});
+			if(numInFlight == 0) return;
+		}
+		unsigned head = *cqHead; //only we write it
+		if(head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)){
+			if(uringEnter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR){
+				ofSleepMillis(1);
+			}
+			continue;
+		}
+		struct io_uring_cqe cqe = cqes[head & *cqMask];
+		__atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+
+		Op * op = (Op *)cqe.user_data;
+		std::unique_lock<std::mutex> lock(mutex); //also orders us after submit(), which the kernel does but tools can't see
+		if(cqe.res > 0 && size_t(cqe.res) < op->len){ //short write, queue the rest
+			op->start += cqe.res;
+			op->len -= cqe.res;
+			op->offset += cqe.res;
+			queue(op);
+			continue;
+		}
+		if(cqe.res == -EAGAIN || cqe.res == -EINTR){
+			queue(op);
+			continue;
+		}
+		if(cqe.res <= 0){ //failed, write it the old way. The buffer is still in flight, nobody touches it
+			const char * data = buffers[op->buffer].data + op->start;
+			size_t len = op->len;
+			uint64_t offset = op->offset;
+			lock.unlock();
+			pwriteAll(data, len, offset);
+			numFallbackWrites++;
+			lock.lock();
+		}
+		buffers[op->buffer].inFlight--;
+		numInFlight--;
+		freeOps.push_back(op);
+		completed.notify_all();
+	}
+}
+
+#else
+
+bool ofxSuperLogUring::isAvailable(){return false;}
+ofxSuperLogUring::~ofxSuperLogUring(){}
+bool ofxSuperLogUring::open(const string & path, bool append, size_t bufferBytes, int numBuffers){return false;}
+void ofxSuperLogUring::close(){}
+void ofxSuperLogUring::write(const char * data, size_t len){}
+void ofxSuperLogUring::submit(){}
+void ofxSuperLogUring::flush(bool sync){}
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ *  ofxSuperLogUring.h
+ *
+ *  Description:
+ *				Append-only file writer on top of io_uring (Linux). Lines are copied into a few
+ *				buffers registered with the kernel, and full (or flushed) buffer slices are queued as
+ *				fixed-buffer writes at explicit offsets. A reaper thread collects the completions, so the
+ *				thread that logged never waits in write() for a busy disk; it only waits when every
+ *				buffer is still in flight.
+ *
+ *				Talks to the kernel through the raw syscalls in <linux/io_uring.h>, no liburing needed.
+ *				isAvailable() is false on other platforms, on kernels without io_uring, and where it's
+ *				blocked (containers, seccomp...); ofxSuperLogFile then keeps using stdio.
+ *				Define SUPERLOG_DISABLE_IO_URING to leave it out of the build.
+ */
+
+#pragma once
+#include "ofMain.h"
+
+#if defined(TARGET_LINUX) && defined(__has_include)
+	#if __has_include(<linux/io_uring.h>) && !defined(SUPERLOG_DISABLE_IO_URING)
+		#define SUPERLOG_IO_URING
+	#endif
+#endif
+
+#ifdef SUPERLOG_IO_URING
+	#include <linux/io_uring.h>
+	#include <sys/uio.h>
+#endif
+
+class ofxSuperLogUring {
+public:
+
+	~ofxSuperLogUring();
+
+	///whether the kernel lets us set up a ring. Probed once.
+	static bool isAvailable();
+
+	///opens path (appending, or truncating it). numBuffers buffers of bufferBytes each are allocated and registered.
+	bool open(const string & path, bool append = true, size_t bufferBytes = 256 * 1024, int numBuffers = 4);
+	void close(); //waits for all the writes to land
+	bool isOpen(){return fd >= 0;}
+	uint64_t getSize(){return nextOffset + pendingBytes();} //file size, once everything lands
+
+	//the following are meant to be called from one thread at a time (ofxSuperLogFile holds its mutex)
+
+	///copies data into the current buffer, queueing it when full. Only blocks if all buffers are in flight.
+	void write(const char * data, size_t len);
+	///queues whatever was written so far, doesn't wait for it
+	void submit();
+	///queues and waits for all writes to complete; then fdatasync()s if sync
+	void flush(bool sync);
+
+	///writes that failed and were re-done with a plain blocking pwrite()
+	uint64_t getNumFallbackWrites(){return numFallbackWrites;}
+
+	///the kernel refused a submission. Everything was still written (with pwrite()), but from then on
+	///every write blocks: close this and write the file some other way.
+	bool hasFailed(){return failed;}
+
+protected:
+
+#ifdef SUPERLOG_IO_URING
+	struct Buffer{
+		char * data;
+		size_t fill = 0; //bytes written into it
+		size_t submitted = 0; //bytes queued
+		int inFlight = 0; //queued slices not completed yet
+	};
+
+	struct Op{ //one queued slice
+		int buffer;
+		size_t start; //in the buffer
+		size_t len;
+		uint64_t offset; //in the file
+		struct iovec iov; //if the buffers couldn't be registered
+	};
+
+	size_t pendingBytes(){return buffers.size() ? buffers[current].fill - buffers[current].submitted : 0;}
+	void queue(Op * op); //call with mutex locked
+	void writeInline(Op * op); //completes op with pwrite(), call with mutex locked
+	void pwriteAll(const char * data, size_t len, uint64_t offset);
+	void nextBuffer();
+	void reap(); //reaper thread
+	bool setupRing(unsigned entries);
+	void destroyRing();
+
+	int ringFd = -1;
+	void * sqPtr = nullptr;
+	void * cqPtr = nullptr;
+	size_t sqPtrSize = 0;
+	size_t cqPtrSize = 0;
+	struct io_uring_sqe * sqes = nullptr;
+	size_t sqesSize = 0;
+	unsigned * sqHead = nullptr;
+	unsigned * sqTail = nullptr;
+	unsigned * sqMask = nullptr;
+	unsigned * sqArray = nullptr;
+	unsigned sqEntries = 0;
+	unsigned * cqHead = nullptr;
+	unsigned * cqTail = nullptr;
+	unsigned * cqMask = nullptr;
+	struct io_uring_cqe * cqes = nullptr;
+	unsigned cqEntries = 0;
+
+	vector<char> memory; //all the buffers, in one block
+	vector<Buffer> buffers;
+	size_t bufferSize = 0;
+	int current = 0;
+	bool registeredBuffers = false;
+
+	vector<Op> ops;
+	vector<Op*> freeOps;
+
+	std::thread reaper;
+	std::mutex mutex; //buffers' inFlight, ops & the submission queue
+	std::condition_variable completed;
+	std::condition_variable queued; //wakes the reaper up
+	int numInFlight = 0;
+	bool stopping = false;
+#else
+	size_t pendingBytes(){return 0;}
+#endif
+
+	int fd = -1;
+	uint64_t nextOffset = 0; //where the next queued slice goes
+	std::atomic<uint64_t> numFallbackWrites{0};
+	std::atomic<bool> failed{false};
+};
@@ -0,0 +1,317 @@
+/**
+ *  ofxSuperLogSearch
+ *
+ *  Description:
+ *				Searches ofxSuperLog log files (a logDirectory archive, or single files) for a string,
+ *				using all cores. Plain files are mmap'ed and split into line aligned chunks, one per
+ *				worker; the substring scan uses SSE2 where available. Compressed segments (.gz, .xz,
+ *				.zst) are decompressed through the system tools, transparently.
+ *
+ *				Understands the file sink line layout, "[ error ] module: 2020/01/01 10:00:00 - message",
+ *				so matches can be filtered by level, module and time range. Lines that don't start with
+ *				a "[level]" header (the tail of multi-line messages) only match when no filter is set.
+ *				That is the default layout only: files written after setFileLogFormat() with another
+ *				pattern can still be searched, but the -l, -m, -f and -t filters won't match them.
+ *
+ *  Build:
+ *				c++ -std=c++11 -O2 -pthread main.cpp -o ofxSuperLogSearch
+ *
+ *  Usage:
+ *				ofxSuperLogSearch [options] pattern path...
+ *					-l level		only records at or above level (verbose, notice, warning, error, fatal)
+ *					-m module		only records from this module
+ *					-f time			only records at or after time, "2020/01/31 14:32:00" (prefixes are fine)
+ *					-t time			only records before time
+ *					-j threads		number of worker threads (default: all cores)
+ *					-c				only print the number of matching lines per file
+ *				paths can be files or directories (all *.log* files in them, in name order).
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+struct Options{
+	string pattern;
+	int minLevel = -1;
+	string module;
+	string from, to;
+	int numThreads = 0;
+	bool countOnly = false;
+	bool filtering() const { return minLevel >= 0 || module.size() || from.size() || to.size(); }
+};
+
+static const char * levelNames[] = {"verbose", "notice", "warning", "error", "fatal"};
+
+//////////////////////////////////////////////////////////////////////////////////// substring search
+
+//first and last needle bytes are compared 16 positions at a time, full compare only on candidates
+static const char * findSubstring(const char * s, size_t n, const char * needle, size_t k){
+	if(k == 0) return s;
+	if(n < k) return nullptr;
+	if(k == 1) return (const char*)memchr(s, needle[0], n);
+	size_t i = 0;
+	#if defined(__SSE2__)
+	const __m128i first = _mm_set1_epi8(needle[0]);
+	const __m128i last = _mm_set1_epi8(needle[k - 1]);
+	for(; i + k - 1 + 16 <= n; i += 16){
+		__m128i blockFirst = _mm_loadu_si128((const __m128i*)(s + i));
+		__m128i blockLast = _mm_loadu_si128((const __m128i*)(s + i + k - 1));
+		unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+		while(mask){
+			int bit = __builtin_ctz(mask);
+			if(memcmp(s + i + bit + 1, needle + 1, k - 2) == 0) return s + i + bit;
+			mask &= mask - 1;
+		}
+	}
+	#endif
+	return (const char*)memmem(s + i, n - i, needle, k);
+}
+
+//////////////////////////////////////////////////////////////////////////////////// line layout
+
+//"[notice ]    module: 2020/01/01 10:00:00 - message"
+static bool passesFilters(const char * line, size_t len, const Options & o){
+	if(len < 3 || line[0] != '[') return false;
+	const char * end = line + len;
+	const char * close = (const char*)memchr(line, ']', len);
+	if(!close) return false;
+
+	if(o.minLevel >= 0){
+		//names are padded to the same width, "[notice ]", "[ error ]"
+		const char * name = line + 1;
+		const char * nameEnd = close;
+		while(name < nameEnd && *name == ' ') name++;
+		while(nameEnd > name && nameEnd[-1] == ' ') nameEnd--;
+		int level = -1;
+		for(int i = 0; i < 5; i++){
+			size_t l = strlen(levelNames[i]);
+			if(size_t(nameEnd - name) == l && strncmp(name, levelNames[i], l) == 0) level = i;
+		}
+		if(level < o.minLevel) return false;
+	}
+
+	const char * modStart = close + 1;
+	while(modStart < end && *modStart == ' ') modStart++;
+	const char * colon = findSubstring(modStart, end - modStart, ": ", 2);
+	if(o.module.size()){
+		if(!colon || size_t(colon - modStart) != o.module.size() || memcmp(modStart, o.module.data(), o.module.size()) != 0) return false;
+	}
+
+	if(o.from.size() || o.to.size()){ //"YYYY/MM/DD HH:MM:SS" sorts lexicographically
+		if(!colon) return false;
+		const char * ts = colon + 2;
+		size_t tsLen = std::min(size_t(end - ts), size_t(26));
+		if(tsLen < 19 || ts[4] != '/' || ts[13] != ':') return false;
+		string t(ts, tsLen);
+		if(o.from.size() && t.compare(0, o.from.size(), o.from) < 0) return false;
+		if(o.to.size() && t.compare(0, o.to.size(), o.to) >= 0) return false;
+	}
+	return true;
+}
+
+static void searchChunk(const char * data, size_t size, const Options & o, string & out, size_t & count){
+	const char * p = data;
+	const char * end = data + size;
+	bool filtering = o.filtering();
+	while(p < end){
+		const char * match = findSubstring(p, end - p, o.pattern.data(), o.pattern.size());
+		if(!match) break;
+		const char * lineStart = match;
+		while(lineStart > data && lineStart[-1] != '\n') lineStart--;
+		const char * lineEnd = (const char*)memchr(match, '\n', end - match);
+		if(!lineEnd) lineEnd = end;
+		if(!filtering || passesFilters(lineStart, lineEnd - lineStart, o)){
+			count++;
+			if(!o.countOnly){
+				out.append(lineStart, lineEnd - lineStart);
+				out.push_back('\n');
+			}
+		}
+		p = lineEnd + 1;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////// files
+
+static bool endsWith(const string & s, const string & e){
+	return s.size() >= e.size() && s.compare(s.size() - e.size(), e.size(), e) == 0;
+}
+
+static bool readCompressed(const string & path, vector<char> & data){
+	const char * tool = endsWith(path, ".gz") ? "gzip" : endsWith(path, ".xz") ? "xz" : "zstd";
+	int fds[2];
+	if(pipe(fds) != 0) return false;
+	pid_t pid = fork();
+	if(pid < 0){
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+	if(pid == 0){ //no shell in between, the path goes to the tool as is
+		dup2(fds[1], STDOUT_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+		const char * args[] = {tool, "-dc", "--", path.c_str(), nullptr};
+		execvp(tool, (char * const *)args);
+		_exit(127);
+	}
+	close(fds[1]);
+	char buf[1 << 16];
+	while(true){
+		ssize_t n = read(fds[0], buf, sizeof(buf));
+		if(n < 0 && errno == EINTR) continue;
+		if(n <= 0) break;
+		data.insert(data.end(), buf, buf + n);
+	}
+	close(fds[0]);
+	int status;
+	while(waitpid(pid, &status, 0) < 0 && errno == EINTR){}
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static void searchFile(const string & path, const Options & o, bool printNames){
+	const char * data = nullptr;
+	size_t size = 0;
+	void * mapped = nullptr;
+	vector<char> decompressed;
+
+	if(endsWith(path, ".gz") || endsWith(path, ".xz") || endsWith(path, ".zst")){
+		if(!readCompressed(path, decompressed)){
+			fprintf(stderr, "can't decompress %s\n", path.c_str());
+			return;
+		}
+		data = decompressed.data();
+		size = decompressed.size();
+	}else{
+		int fd = open(path.c_str(), O_RDONLY);
+		struct stat st;
+		if(fd < 0 || fstat(fd, &st) != 0){
+			fprintf(stderr, "can't open %s\n", path.c_str());
+			if(fd >= 0) close(fd);
+			return;
+		}
+		size = st.st_size;
+		if(size > 0){
+			mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(mapped == MAP_FAILED) mapped = nullptr;
+			else madvise(mapped, size, MADV_SEQUENTIAL);
+		}
+		close(fd);
+		if(size > 0 && !mapped){
+			fprintf(stderr, "can't map %s\n", path.c_str());
+			return;
+		}
+		data = (const char*)mapped;
+	}
+
+	//line aligned chunks, at least 1MB each
+	size_t numChunks = std::max(size_t(1), std::min(size_t(o.numThreads), size / (1 << 20)));
+	vector<size_t> bounds(1, 0);
+	for(size_t i = 1; i < numChunks; i++){
+		size_t b = std::max(bounds.back(), size * i / numChunks);
+		const char * nl = (const char*)memchr(data + b, '\n', size - b);
+		bounds.push_back(nl ? nl - data + 1 : size);
+	}
+	bounds.push_back(size);
+
+	vector<string> results(numChunks);
+	vector<size_t> counts(numChunks, 0);
+	vector<thread> workers;
+	for(size_t i = 0; i < numChunks; i++){
+		workers.emplace_back([&, i]{
+			searchChunk(data + bounds[i], bounds[i + 1] - bounds[i], o, results[i], counts[i]);
+		});
+	}
+	for(auto & w : workers) w.join();
+
+	size_t total = 0;
+	for(size_t i = 0; i < numChunks; i++){ //in file order
+		total += counts[i];
+		if(o.countOnly) continue;
+		if(printNames && results[i].size()){
+			size_t pos = 0;
+			while(pos < results[i].size()){
+				size_t nl = results[i].find('\n', pos);
+				printf("%s:%.*s\n", path.c_str(), int(nl - pos), results[i].data() + pos);
+				pos = nl + 1;
+			}
+		}else{
+			fwrite(results[i].data(), 1, results[i].size(), stdout);
+		}
+	}
+	if(o.countOnly) printf("%s:%zu\n", path.c_str(), total);
+	if(mapped) munmap(mapped, size);
+}
+
+static void collectFiles(const string & path, vector<string> & files){
+	struct stat st;
+	if(stat(path.c_str(), &st) != 0){
+		fprintf(stderr, "can't find %s\n", path.c_str());
+		return;
+	}
+	if(!S_ISDIR(st.st_mode)){
+		files.push_back(path);
+		return;
+	}
+	vector<string> found;
+	if(DIR * dir = opendir(path.c_str())){
+		while(dirent * e = readdir(dir)){
+			string name = e->d_name;
+			bool isIndex = name.size() > 4 && name.compare(name.size() - 4, 4, ".idx") == 0; //ofxSuperLogFile seek index
+			if(name.find(".log") != string::npos && !isIndex) found.push_back(path + "/" + name);
+		}
+		closedir(dir);
+	}
+	sort(found.begin(), found.end()); //log files are named by date
+	files.insert(files.end(), found.begin(), found.end());
+}
+
+int main(int argc, char ** argv){
+	Options o;
+	vector<string> args;
+	for(int i = 1; i < argc; i++){
+		string a = argv[i];
+		bool hasValue = i + 1 < argc;
+		if(a == "-l" && hasValue){
+			string l = argv[++i];
+			for(int k = 0; k < 5; k++) if(l == levelNames[k]) o.minLevel = k;
+			if(o.minLevel < 0){ fprintf(stderr, "unknown level %s\n", l.c_str()); return 1; }
+		}
+		else if(a == "-m" && hasValue) o.module = argv[++i];
+		else if(a == "-f" && hasValue) o.from = argv[++i];
+		else if(a == "-t" && hasValue) o.to = argv[++i];
+		else if(a == "-j" && hasValue) o.numThreads = atoi(argv[++i]);
+		else if(a == "-c") o.countOnly = true;
+		else args.push_back(a);
+	}
+	if(args.size() < 2){
+		fprintf(stderr, "usage: %s [-l level] [-m module] [-f time] [-t time] [-j threads] [-c] pattern path...\n", argv[0]);
+		return 1;
+	}
+	if(o.numThreads <= 0) o.numThreads = std::max(1u, thread::hardware_concurrency());
+	o.pattern = args[0];
+
+	vector<string> files;
+	for(size_t i = 1; i < args.size(); i++) collectFiles(args[i], files);
+	for(auto & f : files) searchFile(f, o, files.size() > 1);
+	return 0;
+}
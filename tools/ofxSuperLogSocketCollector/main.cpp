@@ -0,0 +1,118 @@
+/**
+ *  ofxSuperLogSocketCollector
+ *
+ *  Description:
+ *				Minimal reference collector for ofxSuperLogSocket, for local testing.
+ *				Listens on a Unix-domain socket and prints every record it gets, in the same
+ *				layout as the ofxSuperLog file sink, to stdout or to a file.
+ *
+ *  Build:
+ *				c++ -std=c++11 -O2 main.cpp -o ofxSuperLogSocketCollector
+ *
+ *  Usage:
+ *				ofxSuperLogSocketCollector /tmp/superlog.sock [--dgram] [out.log]
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+static const char * levelNames[] = {"verbose", "notice ", "warning", "error  ", "fatal  ", "silent "};
+static volatile sig_atomic_t quit = 0;
+
+static void onSignal(int){ quit = 1; }
+
+//consumes all complete frames at the start of buf, returns how many bytes were used
+static size_t printFrames(const char * buf, size_t size, FILE * out){
+	size_t off = 0;
+	while(size - off >= 4){
+		uint32_t frameLen;
+		memcpy(&frameLen, buf + off, 4);
+		if(size - off - 4 < frameLen) break;
+		const char * p = buf + off + 4;
+		uint64_t ts; uint8_t level; uint16_t moduleLen;
+		memcpy(&ts, p, 8); p += 8;
+		memcpy(&level, p, 1); p += 1;
+		memcpy(&moduleLen, p, 2); p += 2;
+		size_t messageLen = frameLen - 11 - moduleLen;
+
+		time_t secs = ts / 1000000;
+		struct tm t;
+		localtime_r(&secs, &t);
+		char timeStr[32];
+		strftime(timeStr, sizeof(timeStr), "%Y/%m/%d %H:%M:%S", &t);
+
+		fprintf(out, "[%s] %.*s: %s.%06u - %.*s\n", levelNames[level < 6 ? level : 5], (int)moduleLen, p,
+				timeStr, (unsigned)(ts % 1000000), (int)messageLen, p + moduleLen);
+		off += 4 + frameLen;
+	}
+	fflush(out);
+	return off;
+}
+
+int main(int argc, char ** argv){
+
+	if(argc < 2){
+		fprintf(stderr, "usage: %s socketPath [--dgram] [out.log]\n", argv[0]);
+		return 1;
+	}
+	std::string path = argv[1];
+	bool dgram = false;
+	FILE * out = stdout;
+	for(int i = 2; i < argc; i++){
+		if(strcmp(argv[i], "--dgram") == 0) dgram = true;
+		else if(!(out = fopen(argv[i], "ab"))){
+			perror("fopen");
+			return 1;
+		}
+	}
+
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	signal(SIGPIPE, SIG_IGN);
+
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+	unlink(path.c_str());
+
+	int fd = socket(AF_UNIX, dgram ? SOCK_DGRAM : SOCK_STREAM, 0);
+	if(fd < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || (!dgram && listen(fd, 8) != 0)){
+		perror("socket");
+		return 1;
+	}
+	fprintf(stderr, "listening on %s (%s)\n", path.c_str(), dgram ? "datagram" : "stream");
+
+	std::vector<char> buf(256 * 1024);
+	while(!quit){
+		if(dgram){
+			ssize_t n = recv(fd, buf.data(), buf.size(), 0);
+			if(n > 0) printFrames(buf.data(), n, out);
+			continue;
+		}
+		int client = accept(fd, nullptr, nullptr);
+		if(client < 0) continue;
+		size_t have = 0;
+		while(!quit){
+			if(have == buf.size()) buf.resize(buf.size() * 2); //a frame bigger than our buffer
+			ssize_t n = recv(client, buf.data() + have, buf.size() - have, 0);
+			if(n <= 0) break; //a partial frame left at this point is dropped, the sender resends it
+			have += n;
+			size_t used = printFrames(buf.data(), have, out);
+			memmove(buf.data(), buf.data() + used, have - used);
+			have -= used;
+		}
+		close(client);
+	}
+	close(fd);
+	unlink(path.c_str());
+	return 0;
+}